@@ -3,9 +3,11 @@
 
 //*************************************************************************//
 
+#include <cmath>
 #include <complex>
 
 #include "Matrix.hpp"
+#include "Fixed_Matrix.hpp"
 
 //*************************************************************************//
 //
@@ -69,6 +71,33 @@ private:
     template<typename T>
     bool has_a_main_diagonal_zero(const Matrix<T>&);
 
+    // row with the largest entry in column col at or below row col
+    template<typename T, size_t N>
+    size_t fixed_pivot_row(const Fixed_Matrix<T, N, N>&, size_t col);
+
+    // exchange two rows of a fixed matrix
+    template<typename T, size_t N>
+    void fixed_exchange_rows(Fixed_Matrix<T, N, N>&, size_t, size_t);
+
+    // closed forms for 2x2 and 3x3, elimination otherwise
+    template<typename T>
+    T fixed_determinant(const Fixed_Matrix<T, 2, 2>&);
+
+    template<typename T>
+    T fixed_determinant(const Fixed_Matrix<T, 3, 3>&);
+
+    template<typename T, size_t N>
+    T fixed_determinant(const Fixed_Matrix<T, N, N>&);
+
+    template<typename T>
+    Fixed_Matrix<T, 2, 2> fixed_inverse(const Fixed_Matrix<T, 2, 2>&);
+
+    template<typename T>
+    Fixed_Matrix<T, 3, 3> fixed_inverse(const Fixed_Matrix<T, 3, 3>&);
+
+    template<typename T, size_t N>
+    Fixed_Matrix<T, N, N> fixed_inverse(const Fixed_Matrix<T, N, N>&);
+
 public:
 
     // constructor
@@ -87,21 +116,27 @@ public:
     // destructor
     ~Algebra() = default;
 
+    // the public routines take matrices, matrix views or any other
+    // matrix expression, and read their argument without modifying it
+
     // determine reduced-row echelon form
-    template<typename T>
-    Matrix<T> rref(const Matrix<T>&);
+    template<typename E>
+    Matrix<typename E::value_type> rref(const Matrix_Expression<E>&);
 
     // determine inverse if it exists
-    template<typename T>
-    Matrix<T> inverse(const Matrix<T>&);
+    template<typename E>
+    Matrix<typename E::value_type> inverse(const Matrix_Expression<E>&);
 
-    // find determinant of a complex matrix
-    template<typename T>
-    std::complex<T> determinant(const Matrix<std::complex<T>>&);
+    // find determinant of a real or complex matrix
+    template<typename E>
+    typename E::value_type determinant(const Matrix_Expression<E>&);
 
-    // find determinant of a matrix
-    template<typename T>
-    T determinant(const Matrix<T>&);
+    // fixed size overloads, computed on the stack without allocation
+    template<typename T, size_t N>
+    Fixed_Matrix<T, N, N> inverse(const Fixed_Matrix<T, N, N>&);
+
+    template<typename T, size_t N>
+    T determinant(const Fixed_Matrix<T, N, N>&);
 
 };
 
@@ -333,6 +368,166 @@ bool Algebra::has_a_main_diagonal_zero(const Matrix<T>& M) {
     return has_a_zero;
 }
 
+// row with the largest entry in column col at or below row col
+template<typename T, size_t N>
+size_t Algebra::fixed_pivot_row(const Fixed_Matrix<T, N, N>& M, size_t col) {
+
+    size_t pivot_row = col;
+
+    for(size_t i = col + 1; i < N; ++i) {
+
+        if(std::abs(M(i, col)) > std::abs(M(pivot_row, col))) { pivot_row = i; }
+    }
+
+    return pivot_row;
+}
+
+// exchange two rows of a fixed matrix
+template<typename T, size_t N>
+void Algebra::fixed_exchange_rows(Fixed_Matrix<T, N, N>& M, size_t row_a, size_t row_b) {
+
+    for(size_t j = 0; j < N; ++j) {
+
+        std::swap(M(row_a, j), M(row_b, j));
+    }
+}
+
+// closed form determinants
+template<typename T>
+T Algebra::fixed_determinant(const Fixed_Matrix<T, 2, 2>& M) {
+
+    return M(0, 0) * M(1, 1) - M(0, 1) * M(1, 0);
+}
+
+template<typename T>
+T Algebra::fixed_determinant(const Fixed_Matrix<T, 3, 3>& M) {
+
+    return M(0, 0) * (M(1, 1) * M(2, 2) - M(1, 2) * M(2, 1))
+         - M(0, 1) * (M(1, 0) * M(2, 2) - M(1, 2) * M(2, 0))
+         + M(0, 2) * (M(1, 0) * M(2, 1) - M(1, 1) * M(2, 0));
+}
+
+// determinant by elimination with partial pivoting
+template<typename T, size_t N>
+T Algebra::fixed_determinant(const Fixed_Matrix<T, N, N>& M_in) {
+
+    Fixed_Matrix<T, N, N> M = M_in;
+
+    T det(1);
+
+    for(size_t col = 0; col < N; ++col) {
+
+        size_t pivot_row = Algebra::fixed_pivot_row(M, col);
+
+        if(Algebra::is_zero(M(pivot_row, col))) { return T(0); }
+
+        if(pivot_row != col) {
+
+            Algebra::fixed_exchange_rows(M, pivot_row, col);
+            det = -det;
+        }
+
+        T pivot = M(col, col);
+
+        det *= pivot;
+
+        for(size_t i = col + 1; i < N; ++i) {
+
+            T multiplier = M(i, col) / pivot;
+
+            for(size_t j = col + 1; j < N; ++j) {
+
+                M(i, j) -= M(col, j) * multiplier;
+            }
+        }
+    }
+
+    return det;
+}
+
+// closed form inverses from the adjugate
+template<typename T>
+Fixed_Matrix<T, 2, 2> Algebra::fixed_inverse(const Fixed_Matrix<T, 2, 2>& M) {
+
+    T det = Algebra::fixed_determinant(M);
+
+    if(Algebra::is_zero(det)) { throw std::out_of_range("matrix is singular"); }
+
+    return Fixed_Matrix<T, 2, 2>({  M(1, 1) / det, -M(0, 1) / det,
+                                   -M(1, 0) / det,  M(0, 0) / det });
+}
+
+template<typename T>
+Fixed_Matrix<T, 3, 3> Algebra::fixed_inverse(const Fixed_Matrix<T, 3, 3>& M) {
+
+    // cofactors of the first row give the determinant
+    T c00 = M(1, 1) * M(2, 2) - M(1, 2) * M(2, 1);
+    T c01 = M(1, 2) * M(2, 0) - M(1, 0) * M(2, 2);
+    T c02 = M(1, 0) * M(2, 1) - M(1, 1) * M(2, 0);
+
+    T det = M(0, 0) * c00 + M(0, 1) * c01 + M(0, 2) * c02;
+
+    if(Algebra::is_zero(det)) { throw std::out_of_range("matrix is singular"); }
+
+    T r = T(1) / det;
+
+    return Fixed_Matrix<T, 3, 3>({ c00 * r, (M(0, 2) * M(2, 1) - M(0, 1) * M(2, 2)) * r,
+                                            (M(0, 1) * M(1, 2) - M(0, 2) * M(1, 1)) * r,
+                                   c01 * r, (M(0, 0) * M(2, 2) - M(0, 2) * M(2, 0)) * r,
+                                            (M(0, 2) * M(1, 0) - M(0, 0) * M(1, 2)) * r,
+                                   c02 * r, (M(0, 1) * M(2, 0) - M(0, 0) * M(2, 1)) * r,
+                                            (M(0, 0) * M(1, 1) - M(0, 1) * M(1, 0)) * r });
+}
+
+// inverse by Gauss-Jordan elimination with partial pivoting
+template<typename T, size_t N>
+Fixed_Matrix<T, N, N> Algebra::fixed_inverse(const Fixed_Matrix<T, N, N>& M_in) {
+
+    Fixed_Matrix<T, N, N> M = M_in;
+    Fixed_Matrix<T, N, N> MI = Fixed_Matrix<T, N, N>::identity();
+
+    for(size_t col = 0; col < N; ++col) {
+
+        size_t pivot_row = Algebra::fixed_pivot_row(M, col);
+
+        if(Algebra::is_zero(M(pivot_row, col))) {
+
+            throw std::out_of_range("matrix is singular");
+        }
+
+        if(pivot_row != col) {
+
+            Algebra::fixed_exchange_rows(M, pivot_row, col);
+            Algebra::fixed_exchange_rows(MI, pivot_row, col);
+        }
+
+        // divide pivot row by the pivot
+        T r = T(1) / M(col, col);
+
+        for(size_t j = 0; j < N; ++j) {
+
+            M(col, j) *= r;
+            MI(col, j) *= r;
+        }
+
+        // form zeros above and below the pivot
+        for(size_t i = 0; i < N; ++i) {
+
+            if(i == col) { continue; }
+
+            T multiplier = M(i, col);
+
+            for(size_t j = 0; j < N; ++j) {
+
+                M(i, j) -= M(col, j) * multiplier;
+                MI(i, j) -= MI(col, j) * multiplier;
+            }
+        }
+    }
+
+    return MI;
+}
+
 //*************************************************************************//
 
 //*************************************************************************//
@@ -345,9 +540,11 @@ bool Algebra::has_a_main_diagonal_zero(const Matrix<T>& M) {
 Algebra::Algebra() : determinant_multiplier(1) {}
 
 // determine reduced-row echelon form
-template<typename T>
-Matrix<T> Algebra::rref(const Matrix<T>& M) {
+template<typename E>
+Matrix<typename E::value_type> Algebra::rref(const Matrix_Expression<E>& M) {
     
+    typedef typename E::value_type T;
+
     // initialize matrix for row-reduction
     Matrix<T> MR = M;
     
@@ -364,14 +561,18 @@ Matrix<T> Algebra::rref(const Matrix<T>& M) {
 }
 
 // determine inverse if it exists
-template<typename T>
-Matrix<T> Algebra::inverse(const Matrix<T>& M) {
+template<typename E>
+Matrix<typename E::value_type> Algebra::inverse(const Matrix_Expression<E>& M_in) {
+
+    typedef typename E::value_type T;
+
+    const E& M = M_in.self();
 
     size_t i_end = M.rows();
     size_t j_end = M.columns();
     
-    // make augmented matrix for modification
-    Matrix<T> MA(i_end, 2 * j_end);
+    // make augmented matrix for modification, both halves are filled below
+    Matrix<T> MA(i_end, 2 * j_end, uninitialized);
     
     for(size_t i = 0; i < i_end; ++i) {
 
@@ -406,35 +607,24 @@ Matrix<T> Algebra::inverse(const Matrix<T>& M) {
         // divide rows by pivot points
         Algebra::divide_rows_by_pivots(MA);
         
-        size_t i_end = M.rows();
-        size_t j_end = M.columns();
-
         // copy numbers from right side of MA to MI
-        Matrix<T> MI(i_end, j_end);
-
-        for (size_t i = 0; i < i_end; ++i) {
-
-            for (size_t j = 0; j < j_end; ++j) {
-
-                MI(i, j) = MA(i, j + j_end);
-            }
-        }
-        
-        return MI;
+        return Matrix<T>(MA.slice(0, i_end, j_end, 2 * j_end));
     }
 }
 
-// find determinant of a complex matrix
-template<typename T>
-std::complex<T> Algebra::determinant(const Matrix<std::complex<T>>& M) {
+// find determinant of a real or complex matrix
+template<typename E>
+typename E::value_type Algebra::determinant(const Matrix_Expression<E>& M) {
     
-    if(Algebra::is_square(M)) {
+    typedef typename E::value_type T;
+
+    if(M.self().rows() == M.self().columns()) {
         
         // make copy of M for reduction
-        Matrix<std::complex<T>> MD = M;
+        Matrix<T> MD = M;
 
-        // complex determinant value
-        std::complex<T> det(1, 0);
+        // determinant value
+        T det(1);
 
         // partial reduction
         Algebra::zeros_under_pivots(MD);
@@ -448,52 +638,30 @@ std::complex<T> Algebra::determinant(const Matrix<std::complex<T>>& M) {
         }
         
         // make sure that row-exchanges are accounted for
-        det *= determinant_multiplier;
+        det *= T(determinant_multiplier);
         
         return det;
         
     } else {
         
-        std::complex<T> det(0, 0);
+        T det(0);
 
         return det;
     }
 }
 
-// find determinant of a matrix
-template<typename T>
-T Algebra::determinant(const Matrix<T>& M) {
-    
-    if(Algebra::is_square(M)) {
-        
-        // make copy of M for reduction
-        Matrix<T> MD = M;
-
-        // real determinant value
-        T det = 1;
-
-        // partial reduction
-        Algebra::zeros_under_pivots(MD);
+// determine inverse of a fixed size matrix if it exists
+template<typename T, size_t N>
+Fixed_Matrix<T, N, N> Algebra::inverse(const Fixed_Matrix<T, N, N>& M) {
 
-        size_t i_end = MD.rows();
+    return Algebra::fixed_inverse(M);
+}
 
-        // multiply det by diagonal entries
-        for(size_t i = 0; i < i_end; ++i) {
-            
-            det *= MD(i, i);
-        }
-        
-        // make sure that row-exchanges are accounted for
-        det *= determinant_multiplier;
-        
-        return det;
-        
-    } else {
-        
-        T det = 0;
+// find determinant of a fixed size matrix
+template<typename T, size_t N>
+T Algebra::determinant(const Fixed_Matrix<T, N, N>& M) {
 
-        return det;
-    }
+    return Algebra::fixed_determinant(M);
 }
 
 //*************************************************************************//
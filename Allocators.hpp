@@ -0,0 +1,252 @@
+#ifndef ALLOCATORS_H_INCLUDED
+#define ALLOCATORS_H_INCLUDED
+
+//*************************************************************************//
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <limits>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+//*************************************************************************//
+//
+// allocators for matrix storage
+//
+// Matrix<T, Alloc> takes any standard allocator. Aligned_Allocator puts
+// every row block on a cache line (or wider) boundary, and
+// Huge_Page_Allocator backs large matrices with 2 MiB pages to cut TLB
+// misses during large products:
+//
+//     Matrix<double, Huge_Page_Allocator<double>> M(4096, 4096);
+//
+//*************************************************************************//
+
+// aligned heap memory, released with aligned_free
+inline void* aligned_malloc(size_t bytes, size_t alignment) {
+
+    void* p = 0;
+
+#if defined(_WIN32)
+    p = _aligned_malloc(bytes, alignment);
+#else
+    if(posix_memalign(&p, alignment, bytes) != 0) { p = 0; }
+#endif
+
+    if(!p) { throw std::bad_alloc(); }
+
+    return p;
+}
+
+inline void aligned_free(void* p) {
+
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+//*************************************************************************//
+//
+// aligned allocator
+//
+//*************************************************************************//
+
+template<typename T, size_t Alignment = 64>
+struct Aligned_Allocator {
+
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind { typedef Aligned_Allocator<U, Alignment> other; };
+
+    Aligned_Allocator() {}
+
+    template<typename U>
+    Aligned_Allocator(const Aligned_Allocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+
+        if(n > std::numeric_limits<size_t>::max() / sizeof(T)) { throw std::bad_alloc(); }
+
+        return static_cast<T*>(aligned_malloc(n * sizeof(T), Alignment));
+    }
+
+    void deallocate(T* p, size_t) { aligned_free(p); }
+
+};
+
+template<typename T, typename U, size_t Alignment>
+bool operator == (const Aligned_Allocator<T, Alignment>&,
+                  const Aligned_Allocator<U, Alignment>&) { return true; }
+
+template<typename T, typename U, size_t Alignment>
+bool operator != (const Aligned_Allocator<T, Alignment>&,
+                  const Aligned_Allocator<U, Alignment>&) { return false; }
+
+//*************************************************************************//
+//
+// huge page allocator
+//
+// blocks of at least one huge page first try explicit huge pages
+// (MAP_HUGETLB, which needs pages reserved in /proc/sys/vm/nr_hugepages).
+// if none are available, a 2 MiB aligned anonymous mapping is requested
+// and marked with madvise(MADV_HUGEPAGE) so transparent huge pages can
+// back it. smaller blocks, and systems without mmap, fall back to
+// cache line aligned heap memory.
+//
+//*************************************************************************//
+
+const size_t huge_page_size = 2 * 1024 * 1024;
+
+#if defined(__linux__)
+
+// map at least bytes of huge page backed memory
+inline void* huge_page_map(size_t bytes) {
+
+    size_t length = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+#if defined(MAP_HUGETLB)
+
+    // explicit huge pages
+    void* p = mmap(0, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if(p != MAP_FAILED) { return p; }
+#endif
+
+    // over-map so that a 2 MiB aligned range can be cut out
+    size_t padded = length + huge_page_size;
+
+    void* mapped = mmap(0, padded, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(mapped == MAP_FAILED) { throw std::bad_alloc(); }
+
+    char* raw = static_cast<char*>(mapped);
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (address + huge_page_size - 1) & ~static_cast<uintptr_t>(huge_page_size - 1);
+
+    size_t head = aligned - address;
+    size_t tail = padded - head - length;
+
+    if(head) { munmap(raw, head); }
+    if(tail) { munmap(raw + head + length, tail); }
+
+#if defined(MADV_HUGEPAGE)
+
+    // transparent huge pages
+    madvise(raw + head, length, MADV_HUGEPAGE);
+#endif
+
+    return raw + head;
+}
+
+inline void huge_page_unmap(void* p, size_t bytes) {
+
+    size_t length = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+    munmap(p, length);
+}
+
+#endif
+
+template<typename T>
+struct Huge_Page_Allocator {
+
+    typedef T value_type;
+
+    Huge_Page_Allocator() {}
+
+    template<typename U>
+    Huge_Page_Allocator(const Huge_Page_Allocator<U>&) {}
+
+    T* allocate(size_t n) {
+
+        if(n > std::numeric_limits<size_t>::max() / sizeof(T)) { throw std::bad_alloc(); }
+
+        size_t bytes = n * sizeof(T);
+
+#if defined(__linux__)
+        if(bytes >= huge_page_size) { return static_cast<T*>(huge_page_map(bytes)); }
+#endif
+
+        return static_cast<T*>(aligned_malloc(bytes, 64));
+    }
+
+    void deallocate(T* p, size_t n) {
+
+        size_t bytes = n * sizeof(T);
+
+#if defined(__linux__)
+        if(bytes >= huge_page_size) { huge_page_unmap(p, bytes); return; }
+#endif
+
+        (void)bytes;
+
+        aligned_free(p);
+    }
+
+};
+
+template<typename T, typename U>
+bool operator == (const Huge_Page_Allocator<T>&, const Huge_Page_Allocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator != (const Huge_Page_Allocator<T>&, const Huge_Page_Allocator<U>&) { return false; }
+
+//*************************************************************************//
+//
+// default-initializing allocator adaptor
+//
+// wraps another allocator so that value-less construction default
+// initializes instead of value initializing. std::vector then leaves new
+// elements of trivial types unwritten, which lets Matrix skip the zero
+// fill for storage that is about to be overwritten.
+//
+//*************************************************************************//
+
+template<typename A>
+struct Default_Init_Allocator : public A {
+
+    typedef std::allocator_traits<A> traits;
+
+    typedef typename traits::value_type value_type;
+
+    template<typename U>
+    struct rebind {
+
+        typedef Default_Init_Allocator<typename traits::template rebind_alloc<U>> other;
+    };
+
+    Default_Init_Allocator() {}
+
+    Default_Init_Allocator(const A& a) : A(a) {}
+
+    template<typename B>
+    Default_Init_Allocator(const Default_Init_Allocator<B>& b) : A(static_cast<const B&>(b)) {}
+
+    // default initialization
+    template<typename U>
+    void construct(U* p) { ::new(static_cast<void*>(p)) U; }
+
+    // any other construction goes to the wrapped allocator
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+
+        traits::construct(static_cast<A&>(*this), p, std::forward<Args>(args)...);
+    }
+
+};
+
+//*************************************************************************//
+
+#endif // ALLOCATORS_H_INCLUDED
@@ -0,0 +1,459 @@
+#ifndef BATCH_GEMM_H_INCLUDED
+#define BATCH_GEMM_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <algorithm>
+
+#include "Allocators.hpp"
+#include "Simd.hpp"
+#include "Gemm.hpp"
+
+//*************************************************************************//
+//
+// batched products of many small matrices
+//
+// C_b = A_b * B_b for b = 0 ... batch - 1, where every A_b is m x k, every
+// B_b is k x n, and each operand array stores its matrices back to back
+// in row-major order:
+//
+//     A_b = A + b * m * k,   B_b = B + b * k * n,   C_b = C + b * m * n
+//
+// small float and double products are interleaved across the batch, so
+// that one vector register holds the same element of several matrices
+// and each multiply-add advances all of them at once. larger products
+// already vectorize inside one matrix and go through the packed gemm.
+// with a thread pool the batch is split into chunks, one task per chunk.
+//
+//*************************************************************************//
+
+// products below this many multiply-adds are interleaved across the batch.
+// from 32 x 32 x 32 the packed gemm is faster: moving the operands into
+// lanes and back costs about as much as the interleaved kernel itself
+const size_t batch_interleave_product = gemm_small_product;
+
+// multiply-adds handed to one pool task
+const size_t batch_chunk_work = 1 << 20;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BATCH_INLINE __attribute__((always_inline)) inline
+#else
+#define BATCH_INLINE inline
+#endif
+
+//*************************************************************************//
+//
+// interleaved kernels
+//
+// V is a vector type holding one lane per matrix. operands are stored
+// element by element, each element a V, so A (m x k) is m * k vectors.
+//
+//*************************************************************************//
+
+// an MR x NR block of C from MR rows of A and NR columns of B
+template<typename V, size_t MR, size_t NR>
+BATCH_INLINE void batch_tile(size_t n, size_t k,
+                             const V* A, const V* B, V* C) {
+
+    V ab[MR][NR];
+
+    for(size_t r = 0; r < MR; ++r) {
+
+        for(size_t c = 0; c < NR; ++c) { ab[r][c] = V(); }
+    }
+
+    for(size_t p = 0; p < k; ++p) {
+
+        V b[NR];
+
+        for(size_t c = 0; c < NR; ++c) { b[c] = B[p * n + c]; }
+
+        for(size_t r = 0; r < MR; ++r) {
+
+            V a = A[r * k + p];
+
+            for(size_t c = 0; c < NR; ++c) { ab[r][c] += a * b[c]; }
+        }
+    }
+
+    for(size_t r = 0; r < MR; ++r) {
+
+        for(size_t c = 0; c < NR; ++c) { C[r * n + c] = ab[r][c]; }
+    }
+}
+
+// C = A * B for one interleaved group, tiled MR x 4 with single row
+// and single column tiles along the edges
+template<typename V, size_t MR>
+BATCH_INLINE void batch_lanes_product(size_t m, size_t n, size_t k,
+                                      const V* A, const V* B, V* C) {
+
+    const size_t NR = 4;
+
+    size_t i = 0;
+
+    for(; i + MR <= m; i += MR) {
+
+        size_t j = 0;
+
+        for(; j + NR <= n; j += NR) { batch_tile<V, MR, NR>(n, k, A + i * k, B + j, C + i * n + j); }
+        for(; j < n; ++j) { batch_tile<V, MR, 1>(n, k, A + i * k, B + j, C + i * n + j); }
+    }
+
+    for(; i < m; ++i) {
+
+        size_t j = 0;
+
+        for(; j + NR <= n; j += NR) { batch_tile<V, 1, NR>(n, k, A + i * k, B + j, C + i * n + j); }
+        for(; j < n; ++j) { batch_tile<V, 1, 1>(n, k, A + i * k, B + j, C + i * n + j); }
+    }
+}
+
+#if SIMD_X86
+
+// one register of lanes at each level
+typedef double Batch_Double_128 __attribute__((vector_size(16)));
+typedef double Batch_Double_256 __attribute__((vector_size(32)));
+typedef double Batch_Double_512 __attribute__((vector_size(64)));
+
+typedef float Batch_Float_128 __attribute__((vector_size(16)));
+typedef float Batch_Float_256 __attribute__((vector_size(32)));
+typedef float Batch_Float_512 __attribute__((vector_size(64)));
+
+// 16 registers hold a 2 x 4 block of C, 32 registers a 4 x 4 block
+struct Batch_Sse2 {
+
+    static const size_t lanes_double = 2;
+    static const size_t lanes_float = 4;
+
+    SIMD_TARGET_SSE2
+    static void product(size_t m, size_t n, size_t k,
+                        const double* A, const double* B, double* C) {
+
+        batch_lanes_product<Batch_Double_128, 2>(m, n, k,
+                                                 reinterpret_cast<const Batch_Double_128*>(A),
+                                                 reinterpret_cast<const Batch_Double_128*>(B),
+                                                 reinterpret_cast<Batch_Double_128*>(C));
+    }
+
+    SIMD_TARGET_SSE2
+    static void product(size_t m, size_t n, size_t k,
+                        const float* A, const float* B, float* C) {
+
+        batch_lanes_product<Batch_Float_128, 2>(m, n, k,
+                                                reinterpret_cast<const Batch_Float_128*>(A),
+                                                reinterpret_cast<const Batch_Float_128*>(B),
+                                                reinterpret_cast<Batch_Float_128*>(C));
+    }
+
+};
+
+struct Batch_Avx2 {
+
+    static const size_t lanes_double = 4;
+    static const size_t lanes_float = 8;
+
+    SIMD_TARGET_AVX2
+    static void product(size_t m, size_t n, size_t k,
+                        const double* A, const double* B, double* C) {
+
+        batch_lanes_product<Batch_Double_256, 2>(m, n, k,
+                                                 reinterpret_cast<const Batch_Double_256*>(A),
+                                                 reinterpret_cast<const Batch_Double_256*>(B),
+                                                 reinterpret_cast<Batch_Double_256*>(C));
+    }
+
+    SIMD_TARGET_AVX2
+    static void product(size_t m, size_t n, size_t k,
+                        const float* A, const float* B, float* C) {
+
+        batch_lanes_product<Batch_Float_256, 2>(m, n, k,
+                                                reinterpret_cast<const Batch_Float_256*>(A),
+                                                reinterpret_cast<const Batch_Float_256*>(B),
+                                                reinterpret_cast<Batch_Float_256*>(C));
+    }
+
+};
+
+struct Batch_Avx512 {
+
+    static const size_t lanes_double = 8;
+    static const size_t lanes_float = 16;
+
+    SIMD_TARGET_AVX512
+    static void product(size_t m, size_t n, size_t k,
+                        const double* A, const double* B, double* C) {
+
+        batch_lanes_product<Batch_Double_512, 4>(m, n, k,
+                                                 reinterpret_cast<const Batch_Double_512*>(A),
+                                                 reinterpret_cast<const Batch_Double_512*>(B),
+                                                 reinterpret_cast<Batch_Double_512*>(C));
+    }
+
+    SIMD_TARGET_AVX512
+    static void product(size_t m, size_t n, size_t k,
+                        const float* A, const float* B, float* C) {
+
+        batch_lanes_product<Batch_Float_512, 4>(m, n, k,
+                                                reinterpret_cast<const Batch_Float_512*>(A),
+                                                reinterpret_cast<const Batch_Float_512*>(B),
+                                                reinterpret_cast<Batch_Float_512*>(C));
+    }
+
+};
+
+#endif // SIMD_X86
+
+//*************************************************************************//
+//
+// function tables bound once per value type
+//
+//*************************************************************************//
+
+template<typename T>
+struct Batch_Lanes {
+
+    template<typename K>
+    static size_t of() { return 0; }
+};
+
+template<>
+struct Batch_Lanes<double> {
+
+    template<typename K>
+    static size_t of() { return K::lanes_double; }
+};
+
+template<>
+struct Batch_Lanes<float> {
+
+    template<typename K>
+    static size_t of() { return K::lanes_float; }
+};
+
+template<typename T>
+struct Batch_Kernels {
+
+    // matrices per interleaved group, 0 when there is no kernel
+    size_t lanes;
+
+    // product of one interleaved group
+    void (*product)(size_t, size_t, size_t, const T*, const T*, T*);
+
+    template<typename K>
+    void bind() {
+
+        lanes = Batch_Lanes<T>::template of<K>();
+        product = &K::product;
+    }
+
+    Batch_Kernels()
+
+        : lanes(0)
+        , product(0) {
+
+#if SIMD_X86
+        switch(simd_level()) {
+
+            case simd_avx512: bind<Batch_Avx512>(); break;
+            case simd_avx2: bind<Batch_Avx2>(); break;
+            case simd_sse2: bind<Batch_Sse2>(); break;
+            default: break;
+        }
+#endif
+    }
+
+    static const Batch_Kernels& host() {
+
+        static const Batch_Kernels kernels;
+
+        return kernels;
+    }
+};
+
+// only float and double have interleaved kernels
+template<typename T>
+struct Batch_Interleaved {
+
+    static size_t lanes() { return 0; }
+
+    static void product(size_t, size_t, size_t, const T*, const T*, T*) {}
+};
+
+template<>
+struct Batch_Interleaved<double> {
+
+    static size_t lanes() { return Batch_Kernels<double>::host().lanes; }
+
+    static void product(size_t m, size_t n, size_t k,
+                        const double* A, const double* B, double* C) {
+
+        Batch_Kernels<double>::host().product(m, n, k, A, B, C);
+    }
+};
+
+template<>
+struct Batch_Interleaved<float> {
+
+    static size_t lanes() { return Batch_Kernels<float>::host().lanes; }
+
+    static void product(size_t m, size_t n, size_t k,
+                        const float* A, const float* B, float* C) {
+
+        Batch_Kernels<float>::host().product(m, n, k, A, B, C);
+    }
+};
+
+//*************************************************************************//
+//
+// batch drivers
+//
+//*************************************************************************//
+
+// interleave count matrices of size elements each, padding to lanes with zeros.
+// blocks of 8 elements are moved at once so reads and writes both stay
+// within a few cache lines
+template<typename T>
+void batch_interleave(size_t count, size_t lanes, size_t size,
+                      const T* source, T* buffer) {
+
+    const size_t block = 8;
+
+    size_t e = 0;
+
+    for(; e + block <= size; e += block) {
+
+        T* out = buffer + e * lanes;
+
+        for(size_t l = 0; l < count; ++l) {
+
+            const T* matrix = source + l * size + e;
+
+            for(size_t x = 0; x < block; ++x) { out[x * lanes + l] = matrix[x]; }
+        }
+
+        for(size_t l = count; l < lanes; ++l) {
+
+            for(size_t x = 0; x < block; ++x) { out[x * lanes + l] = T(); }
+        }
+    }
+
+    for(; e < size; ++e) {
+
+        for(size_t l = 0; l < lanes; ++l) { buffer[e * lanes + l] = l < count ? source[l * size + e] : T(); }
+    }
+}
+
+// write count interleaved matrices back to consecutive storage
+template<typename T>
+void batch_deinterleave(size_t count, size_t lanes, size_t size,
+                        const T* buffer, T* destination) {
+
+    const size_t block = 8;
+
+    size_t e = 0;
+
+    for(; e + block <= size; e += block) {
+
+        const T* in = buffer + e * lanes;
+
+        for(size_t l = 0; l < count; ++l) {
+
+            T* matrix = destination + l * size + e;
+
+            for(size_t x = 0; x < block; ++x) { matrix[x] = in[x * lanes + l]; }
+        }
+    }
+
+    for(; e < size; ++e) {
+
+        for(size_t l = 0; l < count; ++l) { destination[l * size + e] = buffer[e * lanes + l]; }
+    }
+}
+
+// products first ... last - 1 of a batch interleaved across lanes on
+// the calling thread, for float and double on hosts with a kernel
+template<typename T>
+void batch_interleaved_range(size_t first, size_t last,
+                             size_t m, size_t n, size_t k,
+                             const T* A, const T* B, T* C) {
+
+    const size_t lanes = Batch_Interleaved<T>::lanes();
+
+    // interleaved groups are kept per thread and reused between calls,
+    // aligned so every lane vector can be loaded whole
+    static thread_local std::vector<T, Aligned_Allocator<T>> a_buffer, b_buffer, c_buffer;
+
+    if(a_buffer.size() < lanes * m * k) { a_buffer.resize(lanes * m * k); }
+    if(b_buffer.size() < lanes * k * n) { b_buffer.resize(lanes * k * n); }
+    if(c_buffer.size() < lanes * m * n) { c_buffer.resize(lanes * m * n); }
+
+    for(size_t b = first; b < last; b += lanes) {
+
+        size_t count = std::min(lanes, last - b);
+
+        batch_interleave(count, lanes, m * k, A + b * m * k, a_buffer.data());
+        batch_interleave(count, lanes, k * n, B + b * k * n, b_buffer.data());
+
+        Batch_Interleaved<T>::product(m, n, k, a_buffer.data(), b_buffer.data(), c_buffer.data());
+
+        batch_deinterleave(count, lanes, m * n, c_buffer.data(), C + b * m * n);
+    }
+}
+
+// products first ... last - 1 of a batch on the calling thread
+template<typename T>
+void batch_gemm_range(size_t first, size_t last,
+                      size_t m, size_t n, size_t k,
+                      const T* A, const T* B, T* C) {
+
+    if(Batch_Interleaved<T>::lanes() != 0 && m * n * k < batch_interleave_product) {
+
+        batch_interleaved_range(first, last, m, n, k, A, B, C);
+
+        return;
+    }
+
+    for(size_t b = first; b < last; ++b) {
+
+        gemm(m, n, k, A + b * m * k, k, B + b * k * n, n, C + b * m * n, n, false);
+    }
+}
+
+// matrices per pool task, a multiple of every lane count
+inline size_t batch_gemm_chunk(size_t m, size_t n, size_t k) {
+
+    size_t chunk = batch_chunk_work / std::max<size_t>(m * n * k, 1);
+
+    return (chunk / 16 + 1) * 16;
+}
+
+// batched product on the calling thread
+template<typename T>
+void batch_gemm(size_t batch, size_t m, size_t n, size_t k,
+                const T* A, const T* B, T* C) {
+
+    batch_gemm_range(0, batch, m, n, k, A, B, C);
+}
+
+// batched product split into chunks of matrices across a thread pool.
+// Pool is any pool with load_range, such as the Thread_Pool of
+// Thread_Pool_G.hpp. a chunk of 0 picks one from the sizes
+template<typename T, typename Pool>
+void batch_gemm(size_t batch, size_t m, size_t n, size_t k,
+                const T* A, const T* B, T* C,
+                Pool& TP, size_t chunk = 0) {
+
+    if(chunk == 0) { chunk = batch_gemm_chunk(m, n, k); }
+
+    TP.load_range(0, batch, chunk, [=](size_t first, size_t last) {
+
+        batch_gemm_range(first, last, m, n, k, A, B, C);
+
+    }).wait_all();
+}
+
+//*************************************************************************//
+
+#endif // BATCH_GEMM_H_INCLUDED
@@ -0,0 +1,858 @@
+#ifndef BILINEAR_H_INCLUDED
+#define BILINEAR_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+
+#include "Strassen.hpp"
+
+//*************************************************************************//
+//
+// bilinear fast multiplication schemes
+//
+// a scheme <m, k, n> of rank R splits A into m x k blocks, B into k x n
+// blocks and C into m x n blocks, and forms C from R block products
+//
+//     P_q   = (sum U[q][i, j] A_ij) * (sum V[q][j, l] B_jl)
+//     C_il  = sum W[i, l][q] P_q
+//
+// Strassen is <2, 2, 2> of rank 7, Laderman <3, 3, 3> of rank 23, the
+// rectangular <2, 3, 3> of rank 15 and its transpose <3, 3, 2>, and the
+// tensor product of two schemes multiplies their shapes and ranks, so
+// Strassen with itself is <4, 4, 4> of rank 49. no <4, 4, 4> scheme of
+// rank 48 is built in, one can be loaded from a scheme file. the
+// coefficients are kept in three row-major tables
+//
+//     u[q * m * k + i * k + j]
+//     v[q * k * n + j * n + l]
+//     w[(i * n + l) * R + q]
+//
+// and a scheme file holds "m k n R" followed by the u, v and w tables as
+// whitespace separated numbers. verify() checks the Brent equations, so
+// a scheme read from a file can be tested before it is used.
+//
+//*************************************************************************//
+
+struct Bilinear_Scheme {
+
+    // block shape and number of products
+    size_t m, k, n, rank;
+
+    // coefficient tables
+    std::vector<double> u, v, w;
+
+    // the trivial <1, 1, 1> scheme
+    Bilinear_Scheme()
+
+        : m(1), k(1), n(1), rank(1)
+        , u(1, 1.0), v(1, 1.0), w(1, 1.0) {}
+
+    // scheme from coefficient tables
+    Bilinear_Scheme(size_t m_in, size_t k_in, size_t n_in, size_t rank_in,
+                    std::vector<double> u_in, std::vector<double> v_in,
+                    std::vector<double> w_in)
+
+        : m(m_in), k(k_in), n(n_in), rank(rank_in)
+        , u(std::move(u_in)), v(std::move(v_in)), w(std::move(w_in)) {
+
+        if(m == 0 || k == 0 || n == 0 || rank == 0 ||
+           u.size() != rank * m * k ||
+           v.size() != rank * k * n ||
+           w.size() != m * n * rank) {
+
+            throw std::out_of_range("scheme tables do not match its dimensions");
+        }
+    }
+
+    // coefficient of block A_ij, B_jl and C_il in product q
+    double a(size_t q, size_t i, size_t j) const { return u[(q * m + i) * k + j]; }
+
+    double b(size_t q, size_t j, size_t l) const { return v[(q * k + j) * n + l]; }
+
+    double c(size_t q, size_t i, size_t l) const { return w[(i * n + l) * rank + q]; }
+
+    // read a scheme, returns false and keeps the current one if the file
+    // cannot be opened or is malformed
+    bool load(const std::string& file_name) {
+
+        std::ifstream fin(file_name);
+
+        if(!fin.is_open()) { return false; }
+
+        size_t m_in = 0, k_in = 0, n_in = 0, rank_in = 0;
+
+        if(!(fin >> m_in >> k_in >> n_in >> rank_in) ||
+           m_in == 0 || k_in == 0 || n_in == 0 || rank_in == 0) { return false; }
+
+        std::vector<double> tables[3] = {
+
+            std::vector<double>(rank_in * m_in * k_in),
+            std::vector<double>(rank_in * k_in * n_in),
+            std::vector<double>(m_in * n_in * rank_in)
+        };
+
+        for(size_t t = 0; t < 3; ++t) {
+
+            for(size_t i = 0; i < tables[t].size(); ++i) {
+
+                if(!(fin >> tables[t][i])) { return false; }
+            }
+        }
+
+        *this = Bilinear_Scheme(m_in, k_in, n_in, rank_in,
+                                std::move(tables[0]), std::move(tables[1]), std::move(tables[2]));
+
+        return true;
+    }
+
+    // write the scheme, returns false if the file cannot be opened
+    bool save(const std::string& file_name) const {
+
+        std::ofstream fout(file_name);
+
+        if(!fout.is_open()) { return false; }
+
+        fout << m << " " << k << " " << n << " " << rank << "\n";
+
+        const std::vector<double>* tables[3] = { &u, &v, &w };
+        size_t widths[3] = { m * k, k * n, rank };
+
+        for(size_t t = 0; t < 3; ++t) {
+
+            for(size_t i = 0; i < tables[t]->size(); ++i) {
+
+                fout << (*tables[t])[i] << ((i + 1) % widths[t] ? " " : "\n");
+            }
+        }
+
+        return static_cast<bool>(fout);
+    }
+
+    // check the Brent equations: the products must sum to A_ij B_jl in
+    // C_il and to nothing anywhere else
+    bool verify(double tolerance = 1e-12) const {
+
+        for(size_t i = 0; i < m; ++i) {
+        for(size_t j = 0; j < k; ++j) {
+        for(size_t jb = 0; jb < k; ++jb) {
+        for(size_t l = 0; l < n; ++l) {
+        for(size_t ic = 0; ic < m; ++ic) {
+        for(size_t lc = 0; lc < n; ++lc) {
+
+            double sum = 0.0;
+
+            for(size_t q = 0; q < rank; ++q) { sum += a(q, i, j) * b(q, jb, l) * c(q, ic, lc); }
+
+            double expected = (j == jb && i == ic && l == lc) ? 1.0 : 0.0;
+
+            if(std::fabs(sum - expected) > tolerance) { return false; }
+        }}}}}}
+
+        return true;
+    }
+
+};
+
+//*************************************************************************//
+//
+// built-in schemes
+//
+//*************************************************************************//
+
+// the classical <m, k, n> scheme, one product per A_ij B_jl
+inline Bilinear_Scheme bilinear_classical(size_t m, size_t k, size_t n) {
+
+    size_t rank = m * k * n;
+
+    std::vector<double> u(rank * m * k), v(rank * k * n), w(m * n * rank);
+
+    for(size_t i = 0; i < m; ++i) {
+
+        for(size_t j = 0; j < k; ++j) {
+
+            for(size_t l = 0; l < n; ++l) {
+
+                size_t q = (i * k + j) * n + l;
+
+                u[(q * m + i) * k + j] = 1.0;
+                v[(q * k + j) * n + l] = 1.0;
+                w[(i * n + l) * rank + q] = 1.0;
+            }
+        }
+    }
+
+    return Bilinear_Scheme(m, k, n, rank, std::move(u), std::move(v), std::move(w));
+}
+
+// Strassen, <2, 2, 2> of rank 7
+inline Bilinear_Scheme bilinear_strassen() {
+
+    static const double u[7 * 4] = {
+     1,  0,  0,  1,
+     0,  0,  1,  1,
+     1,  0,  0,  0,
+     0,  0,  0,  1,
+     1,  1,  0,  0,
+    -1,  0,  1,  0,
+     0,  1,  0, -1
+    };
+
+    static const double v[7 * 4] = {
+     1,  0,  0,  1,
+     1,  0,  0,  0,
+     0,  1,  0, -1,
+    -1,  0,  1,  0,
+     0,  0,  0,  1,
+     1,  1,  0,  0,
+     0,  0,  1,  1
+    };
+
+    static const double w[4 * 7] = {
+     1,  0,  0,  1, -1,  0,  1,
+     0,  0,  1,  0,  1,  0,  0,
+     0,  1,  0,  1,  0,  0,  0,
+     1, -1,  1,  0,  0,  1,  0
+    };
+
+    return Bilinear_Scheme(2, 2, 2, 7,
+                           std::vector<double>(u, u + 7 * 4),
+                           std::vector<double>(v, v + 7 * 4),
+                           std::vector<double>(w, w + 4 * 7));
+}
+
+// Laderman, <3, 3, 3> of rank 23
+inline Bilinear_Scheme bilinear_laderman() {
+
+    static const double u[23 * 9] = {
+     1,  1,  1, -1, -1,  0,  0, -1, -1,
+     1,  0,  0, -1,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  1,  0,  0,  0,  0,
+    -1,  0,  0,  1,  1,  0,  0,  0,  0,
+     0,  0,  0,  1,  1,  0,  0,  0,  0,
+     1,  0,  0,  0,  0,  0,  0,  0,  0,
+    -1,  0,  0,  0,  0,  0,  1,  1,  0,
+    -1,  0,  0,  0,  0,  0,  1,  0,  0,
+     0,  0,  0,  0,  0,  0,  1,  1,  0,
+     1,  1,  1,  0, -1, -1, -1, -1,  0,
+     0,  0,  0,  0,  0,  0,  0,  1,  0,
+     0,  0, -1,  0,  0,  0,  0,  1,  1,
+     0,  0,  1,  0,  0,  0,  0,  0, -1,
+     0,  0,  1,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  1,  1,
+     0,  0, -1,  0,  1,  1,  0,  0,  0,
+     0,  0,  1,  0,  0, -1,  0,  0,  0,
+     0,  0,  0,  0,  1,  1,  0,  0,  0,
+     0,  1,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  1,  0,  0,  0,
+     0,  0,  0,  1,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  1,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  1
+    };
+
+    static const double v[23 * 9] = {
+     0,  0,  0,  0,  1,  0,  0,  0,  0,
+     0, -1,  0,  0,  1,  0,  0,  0,  0,
+    -1,  1,  0,  1, -1, -1, -1,  0,  1,
+     1, -1,  0,  0,  1,  0,  0,  0,  0,
+    -1,  1,  0,  0,  0,  0,  0,  0,  0,
+     1,  0,  0,  0,  0,  0,  0,  0,  0,
+     1,  0, -1,  0,  0,  1,  0,  0,  0,
+     0,  0,  1,  0,  0, -1,  0,  0,  0,
+    -1,  0,  1,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  1,  0,  0,  0,
+    -1,  0,  1,  1, -1, -1, -1,  1,  0,
+     0,  0,  0,  0,  1,  0,  1, -1,  0,
+     0,  0,  0,  0,  1,  0,  0, -1,  0,
+     0,  0,  0,  0,  0,  0,  1,  0,  0,
+     0,  0,  0,  0,  0,  0, -1,  1,  0,
+     0,  0,  0,  0,  0,  1,  1,  0, -1,
+     0,  0,  0,  0,  0,  1,  0,  0, -1,
+     0,  0,  0,  0,  0,  0, -1,  0,  1,
+     0,  0,  0,  1,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  1,  0,
+     0,  0,  1,  0,  0,  0,  0,  0,  0,
+     0,  1,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  1
+    };
+
+    static const double w[9 * 23] = {
+     0,  0,  0,  0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  1,  0,  0,  0,  0,  1,  0,  0,  0,  0,
+     1,  0,  0,  1,  1,  1,  0,  0,  0,  0,  0,  1,  0,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  1,  1,  0,  1,  1,  0,  0,  0,  1,  0,  1,  0,  1,  0,  0,  0,  0,  0,
+     0,  1,  1,  1,  0,  1,  0,  0,  0,  0,  0,  0,  0,  1,  0,  1,  1,  0,  0,  0,  0,  0,  0,
+     0,  1,  0,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  0,  1,  1,  1,  0,  0,  1,  0,  0,
+     0,  0,  0,  0,  0,  1,  1,  1,  0,  0,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  1,  0,
+     0,  0,  0,  0,  0,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1
+    };
+
+    return Bilinear_Scheme(3, 3, 3, 23,
+                           std::vector<double>(u, u + 23 * 9),
+                           std::vector<double>(v, v + 23 * 9),
+                           std::vector<double>(w, w + 9 * 23));
+}
+
+// <2, 3, 3> of rank 15, the rank of Hopcroft and Kerr's algorithm. the
+// coefficients come from a numerical search rounded to -1, 0 and 1 and
+// are checked by verify()
+inline Bilinear_Scheme bilinear_hopcroft_kerr() {
+
+    static const double u[15 * 6] = {
+  0,  0,  0, -1,  1,  0,
+ -1,  0,  0,  1,  0,  1,
+  0, -1, -1,  0,  1,  1,
+  1,  0,  1, -1,  0, -1,
+  0,  0,  0, -1,  0, -1,
+  0,  0, -1,  0,  0,  0,
+ -1,  0,  0,  0,  0,  0,
+  1,  0,  0, -1,  0,  0,
+ -1,  1,  0,  0,  0,  0,
+  0, -1,  0,  0,  1,  0,
+  0,  0,  0,  0,  1,  0,
+  0,  1,  1,  0, -1,  0,
+  0,  0,  0,  0,  0,  1,
+  0, -1, -1,  0,  0,  0,
+ -1,  0,  0,  0,  1,  0
+    };
+
+    static const double v[15 * 9] = {
+ -1, -1,  0,  0,  0,  0,  0,  0,  0,
+  0, -1,  0,  0,  0,  0,  0,  0, -1,
+  0,  0,  0,  0,  0,  0, -1, -1,  0,
+  0,  0,  0,  0,  0,  0,  0,  0, -1,
+  0, -1,  0,  0,  0,  0,  0,  0,  0,
+  0,  0,  0,  0, -1,  0,  0,  1,  1,
+  0, -1, -1,  0,  0, -1,  0,  0,  0,
+  1,  1, -1,  0,  0,  0,  0,  0,  1,
+  0,  0,  0,  0,  0,  1,  0,  0,  0,
+  0,  0,  0,  1,  1, -1, -1, -1,  0,
+  1,  1,  0,  1,  0,  0,  0,  0,  0,
+  0,  0,  0,  0, -1,  0,  1,  1,  0,
+  0, -1,  0,  0,  0,  0, -1,  0,  0,
+  0,  0,  0,  0, -1,  0,  0,  0,  0,
+ -1, -1,  0,  0,  0, -1,  0,  0,  0
+    };
+
+    static const double w[6 * 15] = {
+  0, -1,  0, -1, -1,  1,  0,  0,  1, -1,  1,  1,  0,  0,  1,
+  0,  1,  0,  1,  1, -1,  0,  0,  0,  0,  0,  0,  0,  1,  0,
+  0, -1,  0, -1, -1,  0,  1,  0,  1,  0,  0,  0,  0,  0,  0,
+  1,  0,  0,  0, -1,  0,  0,  0,  0,  0,  1,  0, -1,  0,  0,
+  0,  0, -1,  0,  1,  0,  0,  0,  0,  0,  0,  1,  1,  1,  0,
+  1, -1,  0,  0, -1,  0,  1,  1,  0,  0,  0,  0,  0,  0, -1
+    };
+
+    return Bilinear_Scheme(2, 3, 3, 15,
+                           std::vector<double>(u, u + 15 * 6),
+                           std::vector<double>(v, v + 15 * 9),
+                           std::vector<double>(w, w + 6 * 15));
+}
+
+// transposed scheme, <n, k, m> from <m, k, n> through C^T = B^T A^T
+inline Bilinear_Scheme bilinear_transpose(const Bilinear_Scheme& S) {
+
+    std::vector<double> u(S.rank * S.n * S.k);
+    std::vector<double> v(S.rank * S.k * S.m);
+    std::vector<double> w(S.n * S.m * S.rank);
+
+    for(size_t q = 0; q < S.rank; ++q) {
+
+        for(size_t l = 0; l < S.n; ++l) {
+
+            for(size_t j = 0; j < S.k; ++j) { u[(q * S.n + l) * S.k + j] = S.v[(q * S.k + j) * S.n + l]; }
+        }
+
+        for(size_t j = 0; j < S.k; ++j) {
+
+            for(size_t i = 0; i < S.m; ++i) { v[(q * S.k + j) * S.m + i] = S.u[(q * S.m + i) * S.k + j]; }
+        }
+
+        for(size_t l = 0; l < S.n; ++l) {
+
+            for(size_t i = 0; i < S.m; ++i) { w[(l * S.m + i) * S.rank + q] = S.w[(i * S.n + l) * S.rank + q]; }
+        }
+    }
+
+    return Bilinear_Scheme(S.n, S.k, S.m, S.rank, std::move(u), std::move(v), std::move(w));
+}
+
+// tensor product, S2 applied to the blocks of S1 in one level
+inline Bilinear_Scheme bilinear_product(const Bilinear_Scheme& S1, const Bilinear_Scheme& S2) {
+
+    size_t m = S1.m * S2.m;
+    size_t k = S1.k * S2.k;
+    size_t n = S1.n * S2.n;
+    size_t rank = S1.rank * S2.rank;
+
+    std::vector<double> u(rank * m * k), v(rank * k * n), w(m * n * rank);
+
+    for(size_t q1 = 0; q1 < S1.rank; ++q1) {
+
+        for(size_t q2 = 0; q2 < S2.rank; ++q2) {
+
+            size_t q = q1 * S2.rank + q2;
+
+            for(size_t i = 0; i < m; ++i) {
+
+                for(size_t j = 0; j < k; ++j) {
+
+                    u[(q * m + i) * k + j] = S1.a(q1, i / S2.m, j / S2.k) * S2.a(q2, i % S2.m, j % S2.k);
+                }
+            }
+
+            for(size_t j = 0; j < k; ++j) {
+
+                for(size_t l = 0; l < n; ++l) {
+
+                    v[(q * k + j) * n + l] = S1.b(q1, j / S2.k, l / S2.n) * S2.b(q2, j % S2.k, l % S2.n);
+                }
+            }
+
+            for(size_t i = 0; i < m; ++i) {
+
+                for(size_t l = 0; l < n; ++l) {
+
+                    w[(i * n + l) * rank + q] = S1.c(q1, i / S2.m, l / S2.n) * S2.c(q2, i % S2.m, l % S2.n);
+                }
+            }
+        }
+    }
+
+    return Bilinear_Scheme(m, k, n, rank, std::move(u), std::move(v), std::move(w));
+}
+
+//*************************************************************************//
+//
+// recursive multiplication with a scheme
+//
+// Workspace_Bilinear follows Workspace_Strassen: the sums of blocks and
+// the block products go through three scratch blocks per level taken
+// from one workspace allocated up front, a sum with a single unit
+// coefficient is used in place as a view, and a product that feeds a
+// single block of C with a unit coefficient is accumulated straight
+// into it. dimensions that are not multiples of the block shape are
+// peeled with thin gemm products at every level.
+//
+//*************************************************************************//
+
+// nonzero coefficient of one block
+template<typename T>
+struct Bilinear_Term {
+
+    size_t block;
+    T coefficient;
+};
+
+// X = c A when overwriting, X += c A otherwise
+template<typename T, typename U>
+void bilinear_scale_add(const Matrix_View<T>& X, const Matrix_View<U>& A,
+                        const T& c, bool overwrite) {
+
+    for(size_t i = 0; i < X.rows(); ++i) {
+
+        T* x = &X(i, 0);
+        const T* a = &A(i, 0);
+
+        size_t columns = X.columns();
+
+        if(overwrite) {
+
+            if(c == T(1)) { std::copy(a, a + columns, x); }
+            else { for(size_t j = 0; j < columns; ++j) { x[j] = c * a[j]; } }
+
+        } else {
+
+            if(c == T(1)) { simd_add(x, a, columns); }
+            else if(c == T(-1)) { simd_subtract(x, a, columns); }
+            else { for(size_t j = 0; j < columns; ++j) { x[j] += c * a[j]; } }
+        }
+    }
+}
+
+// dynamic peeling for a core of mc x kc by kc x nc
+template<typename U, typename V, typename T>
+void bilinear_peel(const Matrix_View<U>& A, const Matrix_View<V>& B,
+                   const Matrix_View<T>& C, size_t mc, size_t kc, size_t nc,
+                   bool accumulate) {
+
+    size_t m = A.rows(), k = A.columns(), n = B.columns();
+
+    if(kc != k) {
+
+        strassen_gemm(A.slice(0, mc, kc, k), B.slice(kc, k, 0, nc), C.slice(0, mc, 0, nc), true);
+    }
+
+    if(nc != n) {
+
+        strassen_gemm(A.slice(0, mc, 0, k), B.slice(0, k, nc, n), C.slice(0, mc, nc, n), accumulate);
+    }
+
+    if(mc != m) {
+
+        strassen_gemm(A.slice(mc, m, 0, k), B, C.slice(mc, m, 0, n), accumulate);
+    }
+}
+
+template<typename T>
+struct Workspace_Bilinear {
+
+    // the scheme and its nonzero coefficients per product
+    Bilinear_Scheme scheme;
+
+    std::vector<std::vector<Bilinear_Term<T>>> a_terms, b_terms, c_terms;
+
+    // product dimensions and recursion depth
+    size_t m, k, n, r;
+
+    // scratch for every level
+    std::vector<T> workspace;
+
+    // elements of scratch needed for an m x k by k x n product
+    static size_t workspace_size(const Bilinear_Scheme& S,
+                                 size_t m, size_t k, size_t n, size_t r) {
+
+        size_t total = 0;
+
+        for(; r > 0 && m >= S.m && k >= S.k && n >= S.n; --r) {
+
+            m /= S.m;
+            k /= S.k;
+            n /= S.n;
+
+            total += m * k + k * n + m * n;
+        }
+
+        return total;
+    }
+
+    // constructor
+    Workspace_Bilinear(Bilinear_Scheme S, size_t m_in, size_t k_in, size_t n_in, size_t r_in)
+
+        : scheme(std::move(S))
+        , a_terms(scheme.rank)
+        , b_terms(scheme.rank)
+        , c_terms(scheme.rank)
+        , m(m_in), k(k_in), n(n_in), r(r_in)
+        , workspace(workspace_size(scheme, m_in, k_in, n_in, r_in)) {
+
+        for(size_t q = 0; q < scheme.rank; ++q) {
+
+            for(size_t i = 0; i < scheme.m * scheme.k; ++i) {
+
+                double c = scheme.u[q * scheme.m * scheme.k + i];
+
+                if(c != 0.0) { a_terms[q].push_back(Bilinear_Term<T>{ i, T(c) }); }
+            }
+
+            for(size_t i = 0; i < scheme.k * scheme.n; ++i) {
+
+                double c = scheme.v[q * scheme.k * scheme.n + i];
+
+                if(c != 0.0) { b_terms[q].push_back(Bilinear_Term<T>{ i, T(c) }); }
+            }
+
+            for(size_t i = 0; i < scheme.m * scheme.n; ++i) {
+
+                double c = scheme.w[i * scheme.rank + q];
+
+                if(c != 0.0) { c_terms[q].push_back(Bilinear_Term<T>{ i, T(c) }); }
+            }
+        }
+
+        gemm_reserve<T>();
+    }
+
+    // bytes of scratch held
+    size_t peak_bytes() const { return workspace.size() * sizeof(T); }
+
+    // C = A * B, or C += A * B when accumulating
+    void operator () (const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+                      const Matrix_View<T>& C, bool accumulate = false) {
+
+        if(A.rows() != m || A.columns() != k ||
+           B.rows() != k || B.columns() != n ||
+           C.rows() != m || C.columns() != n) {
+
+            throw std::out_of_range("incorrect dimensions for a bilinear product");
+        }
+
+        recurse(A, B, C, accumulate, r, workspace.data());
+    }
+
+    template<typename Alloc>
+    void operator () (const Matrix<T, Alloc>& A, const Matrix<T, Alloc>& B, Matrix<T, Alloc>& C) {
+
+        (*this)(A.view(), B.view(), C.view());
+    }
+
+private:
+
+    // linear combination of blocks, a single unit term is used in place
+    Matrix_View<const T> combine(const std::vector<Bilinear_Term<T>>& terms,
+                                 const Matrix_View<const T>& M, size_t columns,
+                                 size_t h, size_t w, const Matrix_View<T>& X) {
+
+        if(terms.size() == 1 && terms[0].coefficient == T(1)) {
+
+            size_t i = terms[0].block / columns;
+            size_t j = terms[0].block % columns;
+
+            return M.slice(i * h, (i + 1) * h, j * w, (j + 1) * w);
+        }
+
+        for(size_t t = 0; t < terms.size(); ++t) {
+
+            size_t i = terms[t].block / columns;
+            size_t j = terms[t].block % columns;
+
+            bilinear_scale_add(X, M.slice(i * h, (i + 1) * h, j * w, (j + 1) * w),
+                               terms[t].coefficient, t == 0);
+        }
+
+        return X;
+    }
+
+    void recurse(const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+                 const Matrix_View<T>& C, bool accumulate, size_t depth, T* scratch) {
+
+        const Bilinear_Scheme& S = scheme;
+
+        size_t bm = A.rows() / S.m;
+        size_t bk = A.columns() / S.k;
+        size_t bn = B.columns() / S.n;
+
+        if(depth == 0 || bm == 0 || bk == 0 || bn == 0) {
+
+            strassen_gemm(A, B, C, accumulate);
+
+            return;
+        }
+
+        Matrix_View<T> X(scratch, bm, bk, bk);
+        Matrix_View<T> Y(scratch + bm * bk, bk, bn, bn);
+        Matrix_View<T> Z(scratch + bm * bk + bk * bn, bm, bn, bn);
+
+        T* rest = scratch + bm * bk + bk * bn + bm * bn;
+
+        // the core of C collects every product
+        if(!accumulate) {
+
+            for(size_t i = 0; i < bm * S.m; ++i) { std::fill(&C(i, 0), &C(i, 0) + bn * S.n, T()); }
+        }
+
+        for(size_t q = 0; q < S.rank; ++q) {
+
+            if(a_terms[q].empty() || b_terms[q].empty() || c_terms[q].empty()) { continue; }
+
+            Matrix_View<const T> P = combine(a_terms[q], A, S.k, bm, bk, X);
+            Matrix_View<const T> Q = combine(b_terms[q], B, S.n, bk, bn, Y);
+
+            const std::vector<Bilinear_Term<T>>& terms = c_terms[q];
+
+            if(terms.size() == 1 && terms[0].coefficient == T(1)) {
+
+                size_t i = terms[0].block / S.n;
+                size_t l = terms[0].block % S.n;
+
+                recurse(P, Q, C.slice(i * bm, (i + 1) * bm, l * bn, (l + 1) * bn), true, depth - 1, rest);
+
+                continue;
+            }
+
+            recurse(P, Q, Z, false, depth - 1, rest);
+
+            for(size_t t = 0; t < terms.size(); ++t) {
+
+                size_t i = terms[t].block / S.n;
+                size_t l = terms[t].block % S.n;
+
+                bilinear_scale_add(C.slice(i * bm, (i + 1) * bm, l * bn, (l + 1) * bn),
+                                   Matrix_View<const T>(Z), terms[t].coefficient, false);
+            }
+        }
+
+        // rows, columns and inner indices beyond the block shape
+        bilinear_peel(A, B, C, bm * S.m, bk * S.k, bn * S.n, accumulate);
+    }
+
+};
+
+//*************************************************************************//
+//
+// parallel and serial bilinear functors
+//
+// used like Strassen and Parallel_Strassen. the parallel functor hands
+// the products of one level to the pool and runs pool tasks itself
+// while it waits for them, so it can also be used from inside a task.
+//
+//*************************************************************************//
+
+template<typename T>
+struct Bilinear {
+
+    // intermal matrices
+    Matrix<T> A, B;
+
+    // scheme and depth for recursion
+    Bilinear_Scheme S;
+
+    size_t r;
+
+    // constructor, any m x k by k x n product
+    Bilinear(Matrix<T> A_in, Matrix<T> B_in,
+             Bilinear_Scheme S_in, size_t r_in)
+
+        : A(std::move(A_in))
+        , B(std::move(B_in))
+        , S(std::move(S_in))
+        , r(r_in) {
+
+        if(A.columns() != B.rows()) {
+
+            throw std::out_of_range("incorrect dimensions for a bilinear product");
+        }
+    }
+
+    // operator, recursion works in place with one workspace
+    Matrix<T> operator () () {
+
+        Matrix<T> C(A.rows(), B.columns(), uninitialized);
+
+        Workspace_Bilinear<T>(S, A.rows(), A.columns(), B.columns(), r)(A, B, C);
+
+        return C;
+    }
+
+};
+
+template<typename T>
+struct Parallel_Bilinear {
+
+    // intermal matrices
+    Matrix<T> A, B;
+
+    // scheme and depths for recursion and for using thread pool for parallelism
+    Bilinear_Scheme S;
+
+    size_t r, p;
+
+    // thread pool reference
+    Thread_Pool<Matrix<T>>& TP;
+
+    // constructor, any m x k by k x n product
+    Parallel_Bilinear(Matrix<T> A_in, Matrix<T> B_in,
+                      Bilinear_Scheme S_in, size_t r_in, size_t p_in,
+                      Thread_Pool<Matrix<T>>& TP_in)
+
+        : A(std::move(A_in))
+        , B(std::move(B_in))
+        , S(std::move(S_in))
+        , r(r_in)
+        , p(p_in)
+        , TP(TP_in) {
+
+        if(A.columns() != B.rows()) {
+
+            throw std::out_of_range("incorrect dimensions for a bilinear product");
+        }
+    }
+
+    // operator
+    Matrix<T> operator () () {
+
+        size_t bm = A.rows() / S.m;
+        size_t bk = A.columns() / S.k;
+        size_t bn = B.columns() / S.n;
+
+        // if depth is 0 or the product is smaller than the block shape, perform a blocked gemm product
+        if(r == 0 || bm == 0 || bk == 0 || bn == 0) { return A * B; }
+
+        // decrement depth for recursion
+        r -= 1;
+
+        std::vector<Matrix<T>> P(S.rank);
+        std::vector<Pool_Future<Matrix<T>>> f_P(S.rank);
+
+        for(size_t q = 0; q < S.rank; ++q) {
+
+            Matrix<T> X(bm, bk);
+            Matrix<T> Y(bk, bn);
+
+            for(size_t i = 0; i < S.m; ++i) {
+
+                for(size_t j = 0; j < S.k; ++j) {
+
+                    T c = T(S.a(q, i, j));
+
+                    if(c != T()) {
+
+                        bilinear_scale_add(X.view(), A.slice(i * bm, (i + 1) * bm, j * bk, (j + 1) * bk), c, false);
+                    }
+                }
+            }
+
+            for(size_t j = 0; j < S.k; ++j) {
+
+                for(size_t l = 0; l < S.n; ++l) {
+
+                    T c = T(S.b(q, j, l));
+
+                    if(c != T()) {
+
+                        bilinear_scale_add(Y.view(), B.slice(j * bk, (j + 1) * bk, l * bn, (l + 1) * bn), c, false);
+                    }
+                }
+            }
+
+            if(p == 0) {
+
+                f_P[q] = TP.submit(Bilinear<T>(std::move(X), std::move(Y), S, r));
+
+            } else {
+
+                P[q] = Parallel_Bilinear<T>(std::move(X), std::move(Y), S, r, p - 1, TP)();
+            }
+        }
+
+        // waiting on the products runs pool tasks
+        if(p == 0) {
+
+            for(size_t q = 0; q < S.rank; ++q) { P[q] = f_P[q].get(); }
+        }
+
+        // specify return matrix C, zeroed since the core is accumulated
+        Matrix<T> C(A.rows(), B.columns());
+
+        for(size_t q = 0; q < S.rank; ++q) {
+
+            for(size_t i = 0; i < S.m; ++i) {
+
+                for(size_t l = 0; l < S.n; ++l) {
+
+                    T c = T(S.c(q, i, l));
+
+                    if(c != T()) {
+
+                        bilinear_scale_add(C.slice(i * bm, (i + 1) * bm, l * bn, (l + 1) * bn),
+                                           P[q].view(), c, false);
+                    }
+                }
+            }
+        }
+
+        // rows, columns and inner indices beyond the block shape
+        bilinear_peel(A.view(), B.view(), C.view(), bm * S.m, bk * S.k, bn * S.n, false);
+
+        return C;
+    }
+
+};
+
+//*************************************************************************//
+
+#endif // BILINEAR_H_INCLUDED
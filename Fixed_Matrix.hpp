@@ -0,0 +1,332 @@
+#ifndef FIXED_MATRIX_H_INCLUDED
+#define FIXED_MATRIX_H_INCLUDED
+
+//*************************************************************************//
+
+#include <array>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+
+#include "Matrix_Expression.hpp"
+
+//*************************************************************************//
+//
+// compile-time sized matrix for small dimensions
+//
+// elements live inline in a std::array, so a Fixed_Matrix never touches
+// the heap, its dimensions are constant expressions and every loop is
+// unrolled at compile time. meant for 2x2 to 8x8 transforms:
+//
+//     Fixed_Matrix<double, 4, 4> T = R * S;
+//
+// a Fixed_Matrix is also a matrix expression, so it can be copied into
+// or combined with a dynamic Matrix.
+//
+//*************************************************************************//
+
+// calls f(0), f(1), ..., f(N - 1) with the loop unrolled at compile time
+template<size_t N>
+struct Fixed_Unroll {
+
+    template<typename F>
+    static void apply(const F& f) {
+
+        Fixed_Unroll<N - 1>::apply(f);
+        f(N - 1);
+    }
+};
+
+template<>
+struct Fixed_Unroll<0> {
+
+    template<typename F>
+    static void apply(const F&) {}
+};
+
+template<typename T, size_t R, size_t C>
+class Fixed_Matrix : public Matrix_Expression<Fixed_Matrix<T, R, C>> {
+
+    static_assert(R > 0 && C > 0, "matrix size of 0x0 not allowed");
+
+private:
+
+    // row-major inline storage
+    std::array<T, R * C> elements;
+
+public:
+
+    // element type
+    typedef T value_type;
+
+    // basic constructor, all elements zero
+    Fixed_Matrix();
+
+    // initializer list constructor
+    Fixed_Matrix(std::initializer_list<T>);
+
+    // expression constructor, dimensions are checked at run time
+    template<typename E>
+    explicit Fixed_Matrix(const Matrix_Expression<E>&);
+
+    // move and copy constructors
+    Fixed_Matrix(Fixed_Matrix&&) = default;
+
+    Fixed_Matrix(const Fixed_Matrix&) = default;
+
+    // move and copy assigners
+    Fixed_Matrix& operator = (Fixed_Matrix&&) = default;
+
+    Fixed_Matrix& operator = (const Fixed_Matrix&) = default;
+
+    // destructor
+    ~Fixed_Matrix() = default;
+
+    // show number of rows
+    static constexpr size_t rows() { return R; }
+
+    // show number of columns
+    static constexpr size_t columns() { return C; }
+
+    // reference element access operator
+    T& operator () (size_t, size_t);
+
+    // constant element access operator
+    const T& operator () (size_t, size_t) const;
+
+    // raw row-major storage
+    T* data();
+
+    const T* data() const;
+
+    // test for equality
+    bool operator == (const Fixed_Matrix&) const;
+
+    // test for inequality
+    bool operator != (const Fixed_Matrix&) const;
+
+    // += operator for fixed matrices
+    Fixed_Matrix& operator += (const Fixed_Matrix&);
+
+    // -= operator for fixed matrices
+    Fixed_Matrix& operator -= (const Fixed_Matrix&);
+
+    // transposed copy
+    Fixed_Matrix<T, C, R> transpose() const;
+
+    // identity matrix
+    static Fixed_Matrix identity();
+
+};
+
+// fixed matrices are small enough to be held by reference in expressions
+template<typename T, size_t R, size_t C>
+struct Expression_Operand<Fixed_Matrix<T, R, C>> {
+
+    typedef const Fixed_Matrix<T, R, C>& type;
+};
+
+//*************************************************************************//
+
+// basic constructor
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C>::Fixed_Matrix() { elements.fill(T()); }
+
+// initializer list constructor
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C>::Fixed_Matrix(std::initializer_list<T> l) {
+
+    if(l.size() != R * C) {
+
+        throw std::out_of_range("dimension resolution error");
+    }
+
+    std::copy(l.begin(), l.end(), elements.begin());
+}
+
+// expression constructor
+template<typename T, size_t R, size_t C>
+template<typename E>
+Fixed_Matrix<T, R, C>::Fixed_Matrix(const Matrix_Expression<E>& E_in) {
+
+    const E& e = E_in.self();
+
+    if(e.rows() != R || e.columns() != C) {
+
+        throw std::out_of_range("dimensions do not match");
+    }
+
+    for(size_t i = 0; i < R; ++i) {
+
+        for(size_t j = 0; j < C; ++j) {
+
+            elements[i * C + j] = e(i, j);
+        }
+    }
+}
+
+// reference element access operator
+template<typename T, size_t R, size_t C>
+T& Fixed_Matrix<T, R, C>::operator () (size_t r, size_t c) {
+
+    return elements[(r * C) + c];
+}
+
+// constant element access operator
+template<typename T, size_t R, size_t C>
+const T& Fixed_Matrix<T, R, C>::operator () (size_t r, size_t c) const {
+
+    return elements[(r * C) + c];
+}
+
+// raw row-major storage
+template<typename T, size_t R, size_t C>
+T* Fixed_Matrix<T, R, C>::data() { return elements.data(); }
+
+template<typename T, size_t R, size_t C>
+const T* Fixed_Matrix<T, R, C>::data() const { return elements.data(); }
+
+// comparison operator for equality
+template<typename T, size_t R, size_t C>
+bool Fixed_Matrix<T, R, C>::operator == (const Fixed_Matrix& M) const {
+
+    return elements == M.elements;
+}
+
+// comparison operator for inequality
+template<typename T, size_t R, size_t C>
+bool Fixed_Matrix<T, R, C>::operator != (const Fixed_Matrix& M) const {
+
+    return !(*this == M);
+}
+
+// += operator for fixed matrices
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C>& Fixed_Matrix<T, R, C>::operator += (const Fixed_Matrix& M) {
+
+    T* a = elements.data();
+    const T* b = M.elements.data();
+
+    Fixed_Unroll<R * C>::apply([=](size_t i) { a[i] += b[i]; });
+
+    return *this;
+}
+
+// -= operator for fixed matrices
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C>& Fixed_Matrix<T, R, C>::operator -= (const Fixed_Matrix& M) {
+
+    T* a = elements.data();
+    const T* b = M.elements.data();
+
+    Fixed_Unroll<R * C>::apply([=](size_t i) { a[i] -= b[i]; });
+
+    return *this;
+}
+
+// transposed copy
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, C, R> Fixed_Matrix<T, R, C>::transpose() const {
+
+    Fixed_Matrix<T, C, R> MT;
+
+    T* t = MT.data();
+    const T* a = elements.data();
+
+    Fixed_Unroll<R>::apply([=](size_t i) {
+
+        Fixed_Unroll<C>::apply([=](size_t j) { t[j * R + i] = a[i * C + j]; });
+    });
+
+    return MT;
+}
+
+// identity matrix
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C> Fixed_Matrix<T, R, C>::identity() {
+
+    Fixed_Matrix<T, R, C> I;
+
+    for(size_t i = 0; i < R && i < C; ++i) { I(i, i) = T(1); }
+
+    return I;
+}
+
+//*************************************************************************//
+//
+// arithmetic on fixed matrices
+//
+// these are exact matches for fixed operands and so are preferred over
+// the expression operators, returning fixed matrices computed eagerly
+//
+//*************************************************************************//
+
+// + operator for fixed matrices
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C> operator + (const Fixed_Matrix<T, R, C>& A,
+                                  const Fixed_Matrix<T, R, C>& B) {
+
+    Fixed_Matrix<T, R, C> MS = A;
+
+    return MS += B;
+}
+
+// - operator for fixed matrices
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C> operator - (const Fixed_Matrix<T, R, C>& A,
+                                  const Fixed_Matrix<T, R, C>& B) {
+
+    Fixed_Matrix<T, R, C> MD = A;
+
+    return MD -= B;
+}
+
+// scalar * operators for fixed matrices
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C> operator * (const typename Fixed_Matrix<T, R, C>::value_type& s,
+                                  const Fixed_Matrix<T, R, C>& A) {
+
+    Fixed_Matrix<T, R, C> MS = A;
+
+    T* a = MS.data();
+
+    Fixed_Unroll<R * C>::apply([=](size_t i) { a[i] *= s; });
+
+    return MS;
+}
+
+template<typename T, size_t R, size_t C>
+Fixed_Matrix<T, R, C> operator * (const Fixed_Matrix<T, R, C>& A,
+                                  const typename Fixed_Matrix<T, R, C>::value_type& s) {
+
+    return s * A;
+}
+
+// * operator for fixed matrices, rows of the product are built from
+// scaled rows of B so the innermost unrolled loop vectorizes
+template<typename T, size_t R, size_t K, size_t C>
+Fixed_Matrix<T, R, C> operator * (const Fixed_Matrix<T, R, K>& A,
+                                  const Fixed_Matrix<T, K, C>& B) {
+
+    Fixed_Matrix<T, R, C> MP;
+
+    T* p = MP.data();
+    const T* a = A.data();
+    const T* b = B.data();
+
+    Fixed_Unroll<R>::apply([=](size_t i) {
+
+        Fixed_Unroll<K>::apply([=](size_t k) {
+
+            T a_ik = a[i * K + k];
+
+            Fixed_Unroll<C>::apply([=](size_t j) { p[i * C + j] += a_ik * b[k * C + j]; });
+        });
+    });
+
+    return MP;
+}
+
+//*************************************************************************//
+
+#endif // FIXED_MATRIX_H_INCLUDED
@@ -0,0 +1,463 @@
+#ifndef GEMM_H_INCLUDED
+#define GEMM_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <cstddef>
+
+#include "Simd.hpp"
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+//*************************************************************************//
+//
+// cache blocked, register tiled general matrix multiplication
+//
+// C = op(A) * op(B) or C += op(A) * op(B) on row-major storage with
+// leading dimensions, where op(X) is X or its transpose as chosen by a
+// per-operand flag, 'n' or 't'. transposes are never formed, the packing
+// routines simply read the operand with swapped strides.
+// A is split into mc x kc blocks that stay in L2, B into kc x nc panels
+// that stay in L3, and both are packed so that the micro-kernel streams
+// an mr x kc sliver of A against a kc x nr sliver of B held in L1 while
+// the mr x nr block of C lives in registers.
+//
+//*************************************************************************//
+
+// register tile sizes for a value type
+template<typename T>
+struct Gemm_Tile {
+
+    static const size_t mr = 4;
+    static const size_t nr = 4;
+};
+
+// float and double match the SIMD micro-kernels in Simd.hpp
+template<>
+struct Gemm_Tile<float> {
+
+    static const size_t mr = simd_mr;
+    static const size_t nr = simd_nr_float;
+};
+
+template<>
+struct Gemm_Tile<double> {
+
+    static const size_t mr = simd_mr;
+    static const size_t nr = simd_nr_double;
+};
+
+//*************************************************************************//
+
+// cache sizes of the host, measured once
+struct Gemm_Caches {
+
+    size_t l1, l2, l3;
+
+    Gemm_Caches()
+
+        : l1(32 * 1024)
+        , l2(256 * 1024)
+        , l3(8 * 1024 * 1024) {
+
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+
+        long s1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        long s2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        long s3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+        if(s1 > 0) { l1 = static_cast<size_t>(s1); }
+        if(s2 > 0) { l2 = static_cast<size_t>(s2); }
+        if(s3 > 0) { l3 = static_cast<size_t>(s3); }
+#endif
+    }
+
+    static const Gemm_Caches& host() {
+
+        static const Gemm_Caches caches;
+
+        return caches;
+    }
+};
+
+// cache block sizes for a value type
+template<typename T>
+struct Gemm_Blocking {
+
+    size_t mc, kc, nc;
+
+    Gemm_Blocking() {
+
+        const Gemm_Caches& caches = Gemm_Caches::host();
+
+        const size_t mr = Gemm_Tile<T>::mr;
+        const size_t nr = Gemm_Tile<T>::nr;
+
+        // a kc x nr sliver of B fills half of L1
+        kc = std::max<size_t>(64, caches.l1 / (2 * nr * sizeof(T)));
+        kc = std::min<size_t>(kc, 512);
+
+        // an mc x kc block of A fills half of L2
+        mc = std::max<size_t>(mr, caches.l2 / (2 * kc * sizeof(T)));
+        mc = std::min<size_t>(mc, 512);
+        mc -= mc % mr;
+
+        // a kc x nc panel of B fills half of a core's share of L3
+        nc = std::max<size_t>(nr, std::min<size_t>(caches.l3, 8 * 1024 * 1024) /
+                                      (2 * kc * sizeof(T)));
+        nc = std::min<size_t>(nc, 4096);
+        nc -= nc % nr;
+    }
+
+    static const Gemm_Blocking& host() {
+
+        static const Gemm_Blocking blocking;
+
+        return blocking;
+    }
+};
+
+//*************************************************************************//
+//
+// packing routines
+//
+//*************************************************************************//
+
+// address of element (r, c) of op(X)
+template<typename T>
+inline const T* gemm_element(const T* X, size_t ldx, bool trans,
+                             size_t r, size_t c) {
+
+    return trans ? X + c * ldx + r : X + r * ldx + c;
+}
+
+// pack an mc x kc block of op(A) into row panels of height mr,
+// each stored column by column and padded with zeros
+template<typename T>
+void gemm_pack_a(size_t mc, size_t kc,
+                 const T* A, size_t lda, bool trans, T* buffer) {
+
+    const size_t mr = Gemm_Tile<T>::mr;
+
+    for(size_t i = 0; i < mc; i += mr) {
+
+        size_t m = std::min(mr, mc - i);
+
+        for(size_t p = 0; p < kc; ++p) {
+
+            if(trans) {
+
+                const T* column = A + p * lda + i;
+
+                for(size_t ii = 0; ii < m; ++ii) { buffer[ii] = column[ii]; }
+
+            } else {
+
+                for(size_t ii = 0; ii < m; ++ii) { buffer[ii] = A[(i + ii) * lda + p]; }
+            }
+
+            for(size_t ii = m; ii < mr; ++ii) {
+
+                buffer[ii] = T();
+            }
+
+            buffer += mr;
+        }
+    }
+}
+
+// pack a kc x nc panel of op(B) into column panels of width nr,
+// each stored row by row and padded with zeros
+template<typename T>
+void gemm_pack_b(size_t kc, size_t nc,
+                 const T* B, size_t ldb, bool trans, T* buffer) {
+
+    const size_t nr = Gemm_Tile<T>::nr;
+
+    for(size_t j = 0; j < nc; j += nr) {
+
+        size_t n = std::min(nr, nc - j);
+
+        for(size_t p = 0; p < kc; ++p) {
+
+            if(trans) {
+
+                for(size_t jj = 0; jj < n; ++jj) { buffer[jj] = B[(j + jj) * ldb + p]; }
+
+            } else {
+
+                const T* row = B + p * ldb + j;
+
+                for(size_t jj = 0; jj < n; ++jj) { buffer[jj] = row[jj]; }
+            }
+
+            for(size_t jj = n; jj < nr; ++jj) {
+
+                buffer[jj] = T();
+            }
+
+            buffer += nr;
+        }
+    }
+}
+
+//*************************************************************************//
+//
+// micro-kernel
+//
+//*************************************************************************//
+
+// multiply an mr x kc sliver of packed A by a kc x nr sliver of packed B
+// into the register block ab
+template<typename T>
+void gemm_tile_product(size_t kc, const T* a, const T* b, T* ab) {
+
+    const size_t mr = Gemm_Tile<T>::mr;
+    const size_t nr = Gemm_Tile<T>::nr;
+
+    for(size_t i = 0; i < mr * nr; ++i) { ab[i] = T(); }
+
+    for(size_t p = 0; p < kc; ++p) {
+
+        for(size_t i = 0; i < mr; ++i) {
+
+            T a_i = a[i];
+
+            for(size_t j = 0; j < nr; ++j) {
+
+                ab[i * nr + j] += a_i * b[j];
+            }
+        }
+
+        a += mr;
+        b += nr;
+    }
+}
+
+// float and double use the runtime dispatched SIMD kernels
+inline void gemm_tile_product(size_t kc, const double* a, const double* b, double* ab) {
+
+    const Simd_Kernels<double>& kernels = Simd_Kernels<double>::host();
+
+    if(kernels.micro_kernel) { kernels.micro_kernel(kc, a, b, ab); }
+    else { gemm_tile_product<double>(kc, a, b, ab); }
+}
+
+inline void gemm_tile_product(size_t kc, const float* a, const float* b, float* ab) {
+
+    const Simd_Kernels<float>& kernels = Simd_Kernels<float>::host();
+
+    if(kernels.micro_kernel) { kernels.micro_kernel(kc, a, b, ab); }
+    else { gemm_tile_product<float>(kc, a, b, ab); }
+}
+
+// multiply an mr x kc sliver of packed A by a kc x nr sliver of packed B
+// and store the m x n corner of the result into C
+template<typename T>
+void gemm_micro_kernel(size_t kc, const T* a, const T* b,
+                       T* C, size_t ldc,
+                       size_t m, size_t n, bool accumulate) {
+
+    const size_t mr = Gemm_Tile<T>::mr;
+    const size_t nr = Gemm_Tile<T>::nr;
+
+    // register block of C
+    T ab[mr * nr];
+
+    gemm_tile_product(kc, a, b, ab);
+
+    for(size_t i = 0; i < m; ++i) {
+
+        T* row = C + i * ldc;
+
+        if(accumulate) {
+
+            for(size_t j = 0; j < n; ++j) { row[j] += ab[i * nr + j]; }
+
+        } else {
+
+            for(size_t j = 0; j < n; ++j) { row[j] = ab[i * nr + j]; }
+        }
+    }
+}
+
+//*************************************************************************//
+//
+// driver
+//
+//*************************************************************************//
+
+// products smaller than this many multiply-adds skip packing
+const size_t gemm_small_product = 32 * 32 * 32;
+
+// plain ikj product used for very small operands
+template<typename T>
+void gemm_small(bool trans_a, bool trans_b,
+                size_t m, size_t n, size_t k,
+                const T* A, size_t lda,
+                const T* B, size_t ldb,
+                T* C, size_t ldc, bool accumulate) {
+
+    for(size_t i = 0; i < m; ++i) {
+
+        T* C_row = C + i * ldc;
+
+        if(!accumulate) {
+
+            for(size_t j = 0; j < n; ++j) { C_row[j] = T(); }
+        }
+
+        for(size_t p = 0; p < k; ++p) {
+
+            T a_ip = *gemm_element(A, lda, trans_a, i, p);
+
+            if(trans_b) {
+
+                for(size_t j = 0; j < n; ++j) { C_row[j] += a_ip * B[j * ldb + p]; }
+
+            } else {
+
+                const T* B_row = B + p * ldb;
+
+                for(size_t j = 0; j < n; ++j) { C_row[j] += a_ip * B_row[j]; }
+            }
+        }
+    }
+}
+
+// packing buffers, kept per thread and reused between calls
+template<typename T>
+struct Gemm_Buffers {
+
+    std::vector<T> a, b;
+};
+
+// size the packing buffers of the calling thread, after which its gemm
+// calls no longer allocate
+template<typename T>
+Gemm_Buffers<T>& gemm_reserve() {
+
+    static thread_local Gemm_Buffers<T> buffers;
+
+    const Gemm_Blocking<T>& blocking = Gemm_Blocking<T>::host();
+
+    if(buffers.a.size() < blocking.mc * blocking.kc) { buffers.a.resize(blocking.mc * blocking.kc); }
+    if(buffers.b.size() < blocking.kc * blocking.nc) { buffers.b.resize(blocking.kc * blocking.nc); }
+
+    return buffers;
+}
+
+// read a transpose flag, 'n' for the operand itself and 't' for its transpose
+inline bool gemm_transposed(char flag) {
+
+    if(flag == 'n' || flag == 'N') { return false; }
+    if(flag == 't' || flag == 'T') { return true; }
+
+    throw std::out_of_range("transpose flag must be 'n' or 't'");
+}
+
+// C (m x n) = op(A) (m x k) * op(B) (k x n), or C += op(A) * op(B) if accumulating
+template<typename T>
+void gemm(char flag_a, char flag_b,
+          size_t m, size_t n, size_t k,
+          const T* A, size_t lda,
+          const T* B, size_t ldb,
+          T* C, size_t ldc, bool accumulate) {
+
+    bool trans_a = gemm_transposed(flag_a);
+    bool trans_b = gemm_transposed(flag_b);
+
+    if(m == 0 || n == 0) { return; }
+
+    if(k == 0) {
+
+        if(!accumulate) {
+
+            for(size_t i = 0; i < m; ++i) {
+
+                std::fill(C + i * ldc, C + i * ldc + n, T());
+            }
+        }
+
+        return;
+    }
+
+    if(m * n * k < gemm_small_product) {
+
+        gemm_small(trans_a, trans_b, m, n, k, A, lda, B, ldb, C, ldc, accumulate);
+        return;
+    }
+
+    const size_t mr = Gemm_Tile<T>::mr;
+    const size_t nr = Gemm_Tile<T>::nr;
+
+    const Gemm_Blocking<T>& blocking = Gemm_Blocking<T>::host();
+
+    const size_t mc = blocking.mc;
+    const size_t kc = blocking.kc;
+    const size_t nc = blocking.nc;
+
+    Gemm_Buffers<T>& buffers = gemm_reserve<T>();
+
+    std::vector<T>& a_buffer = buffers.a;
+    std::vector<T>& b_buffer = buffers.b;
+
+    for(size_t jc = 0; jc < n; jc += nc) {
+
+        size_t n_block = std::min(nc, n - jc);
+
+        for(size_t pc = 0; pc < k; pc += kc) {
+
+            size_t k_block = std::min(kc, k - pc);
+
+            // only the first pass over k may overwrite C
+            bool add = accumulate || pc != 0;
+
+            gemm_pack_b(k_block, n_block, gemm_element(B, ldb, trans_b, pc, jc),
+                        ldb, trans_b, b_buffer.data());
+
+            for(size_t ic = 0; ic < m; ic += mc) {
+
+                size_t m_block = std::min(mc, m - ic);
+
+                gemm_pack_a(m_block, k_block, gemm_element(A, lda, trans_a, ic, pc),
+                            lda, trans_a, a_buffer.data());
+
+                for(size_t jr = 0; jr < n_block; jr += nr) {
+
+                    const T* b = b_buffer.data() + jr * k_block;
+
+                    for(size_t ir = 0; ir < m_block; ir += mr) {
+
+                        const T* a = a_buffer.data() + ir * k_block;
+
+                        gemm_micro_kernel(k_block, a, b,
+                                          C + (ic + ir) * ldc + jc + jr, ldc,
+                                          std::min(mr, m_block - ir),
+                                          std::min(nr, n_block - jr), add);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// C (m x n) = A (m x k) * B (k x n), or C += A * B if accumulating
+template<typename T>
+void gemm(size_t m, size_t n, size_t k,
+          const T* A, size_t lda,
+          const T* B, size_t ldb,
+          T* C, size_t ldc, bool accumulate) {
+
+    gemm('n', 'n', m, n, k, A, lda, B, ldb, C, ldc, accumulate);
+}
+
+//*************************************************************************//
+
+#endif // GEMM_H_INCLUDED
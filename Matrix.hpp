@@ -5,6 +5,22 @@
 
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
+
+#include "Allocators.hpp"
+#include "Simd.hpp"
+#include "Gemm.hpp"
+#include "Transpose.hpp"
+#include "Matrix_Expression.hpp"
+#include "Matrix_View.hpp"
+#include "Parallel.hpp"
+
+//*************************************************************************//
+
+// tag for constructing a matrix whose elements are left unwritten
+struct Uninitialized_Tag {};
+
+const Uninitialized_Tag uninitialized = Uninitialized_Tag();
 
 //*************************************************************************//
 //
@@ -12,17 +28,27 @@
 //
 //*************************************************************************//
 
-template<typename T>
-class Matrix {
+// the allocator defaults to std::allocator<T>, see Matrix_Expression.hpp
+template<typename T, typename Alloc>
+class Matrix : public Matrix_Expression<Matrix<T, Alloc>> {
     
 private:
     
     // rows, columns
     size_t n_rows, n_columns, total_elements;
     
-    std::vector<T> elements;
+    // storage skips value initialization unless it is asked for,
+    // see Default_Init_Allocator in Allocators.hpp
+    std::vector<T, Default_Init_Allocator<Alloc>> elements;
+
+    // write an expression into storage of matching size
+    template<typename E>
+    void evaluate(const Matrix_Expression<E>&);
 
 public:
+
+    // element type
+    typedef T value_type;
     
 //*************************************************************************//
 //
@@ -33,10 +59,14 @@ public:
     // basic constructors
     Matrix(size_t, size_t);
     
-    Matrix(size_t);
+    explicit Matrix(size_t);
     
     Matrix();
 
+    // uninitialized constructor, for results that are about to be
+    // overwritten. elements of trivial types hold indeterminate values
+    Matrix(size_t, size_t, Uninitialized_Tag);
+
     // initializer list constructor
     Matrix(size_t, size_t, std::initializer_list<T>);
 
@@ -45,11 +75,19 @@ public:
 
     Matrix(const Matrix&) = default;
 
+    // expression constructor, evaluates in a single pass
+    template<typename E>
+    Matrix(const Matrix_Expression<E>&);
+
     // move and copy assigners
     Matrix& operator = (Matrix&&) = default;
 
     Matrix& operator = (const Matrix&) = default;
 
+    // expression assigner
+    template<typename E>
+    Matrix& operator = (const Matrix_Expression<E>&);
+
     // destructor
     ~Matrix() = default;
     
@@ -64,6 +102,11 @@ public:
     
     // constant element access operator
     T operator () (size_t, size_t) const;
+
+    // raw row-major storage
+    T* data();
+
+    const T* data() const;
     
     // row exchange function
     void exchange_rows(size_t, size_t);
@@ -76,19 +119,32 @@ public:
     
     // += operator for matrices
     Matrix& operator += (const Matrix&);
+
+    template<typename E>
+    Matrix& operator += (const Matrix_Expression<E>&);
     
     // -= operator for matrices
     Matrix& operator -= (const Matrix&);
 
-    // matrix slice
-    Matrix slice(size_t, size_t, size_t, size_t);
+    template<typename E>
+    Matrix& operator -= (const Matrix_Expression<E>&);
+
+    // view of the whole matrix
+    Matrix_View<T> view();
+
+    Matrix_View<const T> view() const;
+
+    // matrix slice, a view of rows [row_a, row_b) and columns [column_a, column_b)
+    Matrix_View<T> slice(size_t, size_t, size_t, size_t);
+
+    Matrix_View<const T> slice(size_t, size_t, size_t, size_t) const;
+
+    // transposed copy
+    Matrix transpose() const;
+
+    // transpose a square matrix in place
+    void transpose_in_place();
 
-    // + operator for matrices
-    Matrix operator + (const Matrix&) const;
-    
-    // - operator for matrices
-    Matrix operator - (const Matrix&) const;
-    
     // * operator for matrices
     Matrix operator * (const Matrix&) const;
     
@@ -103,13 +159,13 @@ public:
 //*************************************************************************//
 
 // basic constructors
-template<typename T>
-Matrix<T>::Matrix(size_t r, size_t c)
+template<typename T, typename Alloc>
+Matrix<T, Alloc>::Matrix(size_t r, size_t c)
 	
 	: n_rows(r)
 	, n_columns(c)
 	, total_elements(r * c)
-	, elements(r * c) {
+	, elements(r * c, T()) {
     
     if(n_rows == 0 || n_columns == 0) {
         
@@ -117,13 +173,13 @@ Matrix<T>::Matrix(size_t r, size_t c)
     }
 }
 
-template<typename T>
-Matrix<T>::Matrix(size_t r)
+template<typename T, typename Alloc>
+Matrix<T, Alloc>::Matrix(size_t r)
 
 	: n_rows(r)
 	, n_columns(1)
 	, total_elements(r)
-	, elements(r) {
+	, elements(r, T()) {
 
     if(n_rows == 0) {
         
@@ -131,17 +187,32 @@ Matrix<T>::Matrix(size_t r)
     }
 }
 
-template<typename T>
-Matrix<T>::Matrix()
+template<typename T, typename Alloc>
+Matrix<T, Alloc>::Matrix()
     
 	: n_rows(1)
 	, n_columns(1)
 	, total_elements(1)
-	, elements(1) {}
+	, elements(1, T()) {}
+
+// uninitialized constructor
+template<typename T, typename Alloc>
+Matrix<T, Alloc>::Matrix(size_t r, size_t c, Uninitialized_Tag)
+
+    : n_rows(r)
+    , n_columns(c)
+    , total_elements(r * c)
+    , elements(r * c) {
+
+    if(n_rows == 0 || n_columns == 0) {
+
+        throw std::out_of_range("matrix size of 0x0 not allowed");
+    }
+}
 
 // initializer list constructor
-    template<typename T>
-Matrix<T>::Matrix(size_t r, size_t c,
+template<typename T, typename Alloc>
+Matrix<T, Alloc>::Matrix(size_t r, size_t c,
                   std::initializer_list<T> l)
 
     : n_rows(r)
@@ -155,31 +226,102 @@ Matrix<T>::Matrix(size_t r, size_t c,
     }
 }
 
+// expression constructor, evaluates in a single pass
+template<typename T, typename Alloc>
+template<typename E>
+Matrix<T, Alloc>::Matrix(const Matrix_Expression<E>& E_in)
+
+    : n_rows(E_in.self().rows())
+    , n_columns(E_in.self().columns())
+    , total_elements(n_rows * n_columns)
+    , elements(n_rows * n_columns) {
+
+    if(n_rows == 0 || n_columns == 0) {
+
+        throw std::out_of_range("matrix size of 0x0 not allowed");
+    }
+
+    // every element is written by the evaluation
+
+    Matrix<T, Alloc>::evaluate(E_in);
+}
+
+// expression assigner
+template<typename T, typename Alloc>
+template<typename E>
+Matrix<T, Alloc>& Matrix<T, Alloc>::operator = (const Matrix_Expression<E>& E_in) {
+
+    if(n_rows != E_in.self().rows() || n_columns != E_in.self().columns()) {
+
+        // the expression may still read from this matrix
+        Matrix<T, Alloc> MR(E_in);
+
+        *this = std::move(MR);
+
+    } else {
+
+        Matrix<T, Alloc>::evaluate(E_in);
+    }
+
+    return *this;
+}
+
+// write an expression into storage of matching size
+template<typename T, typename Alloc>
+template<typename E>
+void Matrix<T, Alloc>::evaluate(const Matrix_Expression<E>& E_in) {
+
+    const E& e = E_in.self();
+
+    // large matrices are written by rows across the shared pool
+    parallel_rows(n_rows, n_columns, [this, &e](size_t first, size_t last) {
+
+        size_t index;
+
+        for(size_t i = first; i < last; ++i) {
+
+            index = i * n_columns;
+
+            for(size_t j = 0; j < n_columns; ++j) {
+
+                elements[index + j] = e(i, j);
+            }
+        }
+    });
+}
+
 // show number of rows
-template<typename T>
-size_t Matrix<T>::rows() const { return n_rows; }
+template<typename T, typename Alloc>
+size_t Matrix<T, Alloc>::rows() const { return n_rows; }
 
 // show number of columns
-template<typename T>
-size_t Matrix<T>::columns() const { return n_columns; }
+template<typename T, typename Alloc>
+size_t Matrix<T, Alloc>::columns() const { return n_columns; }
 
 // reference element access operator
-template<typename T>
-T& Matrix<T>::operator () (size_t r, size_t c) {
+template<typename T, typename Alloc>
+T& Matrix<T, Alloc>::operator () (size_t r, size_t c) {
     
     return elements[(r * n_columns) + c];
 }
 
 // constant element access operator
-template<typename T>
-T Matrix<T>::operator () (size_t r, size_t c) const {
+template<typename T, typename Alloc>
+T Matrix<T, Alloc>::operator () (size_t r, size_t c) const {
     
     return elements[(r * n_columns) + c];
 }
 
+// raw row-major storage
+template<typename T, typename Alloc>
+T* Matrix<T, Alloc>::data() { return elements.data(); }
+
+template<typename T, typename Alloc>
+const T* Matrix<T, Alloc>::data() const { return elements.data(); }
+
 // row exchange function
-template<typename T>
-void Matrix<T>::exchange_rows(size_t row_a, size_t row_b) {
+template<typename T, typename Alloc>
+void Matrix<T, Alloc>::exchange_rows(size_t row_a, size_t row_b) {
     
     if(row_a > n_rows || row_b > n_rows) {
         
@@ -196,8 +338,8 @@ void Matrix<T>::exchange_rows(size_t row_a, size_t row_b) {
 }
 
 // comparison operator for equality
-template<typename T>
-bool Matrix<T>::operator == (const Matrix<T>& M) {
+template<typename T, typename Alloc>
+bool Matrix<T, Alloc>::operator == (const Matrix<T, Alloc>& M) {
 
     if(n_rows != M.n_rows || n_columns != M.n_columns) {
 
@@ -205,164 +347,306 @@ bool Matrix<T>::operator == (const Matrix<T>& M) {
     
     } else {
 
-        bool equal = true;
-
-        for(size_t i = 0; i < total_elements; ++i) {
-
-        	if(elements[i] != M.elements[i]) {
-
-        		equal = false;
-        		i = total_elements;
-        	}
-        }
-
-        return equal;
+        return simd_equal(elements.data(), M.elements.data(), total_elements);
     }
 }
 
 // comparison operator for inequality
-template<typename T>
-bool Matrix<T>::operator != (const Matrix<T>& M) {
-
-    if(n_rows != M.n_rows || n_columns != M.n_columns) {
-
-        return true;
-    
-    } else {
-
-        bool not_equal = false;
-
-        for(size_t i = 0; i < total_elements; ++i) {
-
-            if(elements[i] != M.elements[i]) {
-
-                not_equal = true;
-                i = total_elements;
-            }
-        }
+template<typename T, typename Alloc>
+bool Matrix<T, Alloc>::operator != (const Matrix<T, Alloc>& M) {
 
-        return not_equal;
-    }
+    return !(*this == M);
 }
 
 // += operators for matrices
-template<typename T>
-Matrix<T>& Matrix<T>::operator += (const Matrix<T>& M) {
+template<typename T, typename Alloc>
+Matrix<T, Alloc>& Matrix<T, Alloc>::operator += (const Matrix<T, Alloc>& M) {
     
     if(n_rows != M.n_rows || n_columns != M.n_columns) {
         
         throw std::out_of_range("dimensions do not match");
     }
     
-    for(size_t i = 0; i < total_elements; ++i) {
+    T* a = elements.data();
+    const T* b = M.elements.data();
 
-    	elements[i] += M.elements[i];
-	}
+    parallel_rows(total_elements, 1, [a, b](size_t first, size_t last) {
+
+        simd_add(a + first, b + first, last - first);
+    });
     
     return *this;
 }
 
 // -= operators for matrices
-template<typename T>
-Matrix<T>& Matrix<T>::operator -= (const Matrix<T>& M) {
+template<typename T, typename Alloc>
+Matrix<T, Alloc>& Matrix<T, Alloc>::operator -= (const Matrix<T, Alloc>& M) {
     
     if(n_rows != M.n_rows || n_columns != M.n_columns) {
         
         throw std::out_of_range("dimensions do not match");
     }
     
-    for(size_t i = 0; i < total_elements; ++i) {
+    T* a = elements.data();
+    const T* b = M.elements.data();
+
+    parallel_rows(total_elements, 1, [a, b](size_t first, size_t last) {
 
-    	elements[i] -= M.elements[i];
-	}
+        simd_subtract(a + first, b + first, last - first);
+    });
     
     return *this;
 }
 
-// matrix slice
-template<typename T>
-Matrix<T> Matrix<T>::slice(size_t row_a, size_t row_b,
-                        size_t column_a, size_t column_b) {
-    
-    size_t row_range = row_b - row_a;
-    size_t column_range = column_b - column_a;
+// += operator for matrix expressions, evaluated in a single pass
+template<typename T, typename Alloc>
+template<typename E>
+Matrix<T, Alloc>& Matrix<T, Alloc>::operator += (const Matrix_Expression<E>& E_in) {
+
+    const E& e = E_in.self();
+
+    if(n_rows != e.rows() || n_columns != e.columns()) {
+
+        throw std::out_of_range("dimensions do not match");
+    }
 
-    Matrix<T> MP(row_range, column_range);
+    parallel_rows(n_rows, n_columns, [this, &e](size_t first, size_t last) {
 
-    size_t MP_index, index;
+        size_t index;
 
-    for(size_t i = 0; i < row_range; ++i) {
+        for(size_t i = first; i < last; ++i) {
 
-        MP_index = i * MP.n_columns;
-        index = (row_a + i) * n_columns;
+            index = i * n_columns;
 
-        for(size_t j = 0; j < column_range; ++j) {
+            for(size_t j = 0; j < n_columns; ++j) {
 
-            MP.elements[MP_index + j] = elements[index + column_a + j];
+                elements[index + j] += e(i, j);
+            }
         }
+    });
+
+    return *this;
+}
+
+// -= operator for matrix expressions, evaluated in a single pass
+template<typename T, typename Alloc>
+template<typename E>
+Matrix<T, Alloc>& Matrix<T, Alloc>::operator -= (const Matrix_Expression<E>& E_in) {
+
+    const E& e = E_in.self();
+
+    if(n_rows != e.rows() || n_columns != e.columns()) {
+
+        throw std::out_of_range("dimensions do not match");
     }
-    
-    return MP;
+
+    parallel_rows(n_rows, n_columns, [this, &e](size_t first, size_t last) {
+
+        size_t index;
+
+        for(size_t i = first; i < last; ++i) {
+
+            index = i * n_columns;
+
+            for(size_t j = 0; j < n_columns; ++j) {
+
+                elements[index + j] -= e(i, j);
+            }
+        }
+    });
+
+    return *this;
 }
 
-// + operator for matrices
-template<typename T>
-Matrix<T> Matrix<T>::operator + (const Matrix<T>& M) const {
-    
-    Matrix<T> MS = *this;
-    MS += M;
+// view of the whole matrix
+template<typename T, typename Alloc>
+Matrix_View<T> Matrix<T, Alloc>::view() {
 
-    return MS;
+    return Matrix_View<T>(elements.data(), n_rows, n_columns, n_columns);
 }
 
-// - operator for matrices
-template<typename T>
-Matrix<T> Matrix<T>::operator - (const Matrix<T>& M) const {
+template<typename T, typename Alloc>
+Matrix_View<const T> Matrix<T, Alloc>::view() const {
+
+    return Matrix_View<const T>(elements.data(), n_rows, n_columns, n_columns);
+}
+
+// matrix slice
+template<typename T, typename Alloc>
+Matrix_View<T> Matrix<T, Alloc>::slice(size_t row_a, size_t row_b,
+                                size_t column_a, size_t column_b) {
     
-    Matrix<T> MD = *this;
-    MD -= M;
+    return Matrix<T, Alloc>::view().slice(row_a, row_b, column_a, column_b);
+}
+
+template<typename T, typename Alloc>
+Matrix_View<const T> Matrix<T, Alloc>::slice(size_t row_a, size_t row_b,
+                                      size_t column_a, size_t column_b) const {
 
-    return MD;
+    return Matrix<T, Alloc>::view().slice(row_a, row_b, column_a, column_b);
+}
+
+// transposed copy, see Transpose.hpp
+template<typename T, typename Alloc>
+Matrix<T, Alloc> Matrix<T, Alloc>::transpose() const {
+
+    Matrix<T, Alloc> MT(n_columns, n_rows, uninitialized);
+
+    transpose_block(n_rows, n_columns,
+                    elements.data(), n_columns,
+                    MT.elements.data(), MT.n_columns);
+
+    return MT;
+}
+
+// transpose a square matrix in place
+template<typename T, typename Alloc>
+void Matrix<T, Alloc>::transpose_in_place() {
+
+    if(n_rows != n_columns) {
+
+        throw std::out_of_range("in place transpose requires a square matrix");
+    }
+
+    transpose_square(n_rows, elements.data(), n_columns);
 }
 
 // * operator for matrices
-template<typename T>
-Matrix<T> Matrix<T>::operator * (const Matrix<T>& M) const {
+template<typename T, typename Alloc>
+Matrix<T, Alloc> Matrix<T, Alloc>::operator * (const Matrix<T, Alloc>& M) const {
     
     if(n_columns != M.n_rows) {
         
         throw std::out_of_range("incorrect dimensions for a product");
     }
     
-    Matrix<T> MP(n_rows, M.n_columns);
-    
-    size_t i_end = n_rows;
-    size_t k_end = n_columns;
-    size_t j_end = M.n_columns;
+    Matrix<T, Alloc> MP(n_rows, M.n_columns, uninitialized);
 
-    size_t MP_index, index, M_index;
+    // blocked product, see Gemm.hpp
+    gemm(n_rows, M.n_columns, n_columns,
+         elements.data(), n_columns,
+         M.elements.data(), M.n_columns,
+         MP.elements.data(), MP.n_columns, false);
 
-    for(size_t i = 0; i < i_end; ++i) {
+    return MP;
+}
 
-        MP_index = j_end * i;
-        index = k_end * i;
+//*************************************************************************//
+//
+// products of matrix views
+//
+//*************************************************************************//
+
+// product of two views written into a new matrix of type M
+template<typename M, typename T, typename U>
+M view_product(const Matrix_View<T>& A, const Matrix_View<U>& B) {
 
-        for(size_t k = 0; k < k_end; ++k) {
+    if(A.columns() != B.rows()) {
 
-            M_index = j_end * k;
+        throw std::out_of_range("incorrect dimensions for a product");
+    }
 
-            for(size_t j = 0; j < j_end; ++j) {
+    M MP(A.rows(), B.columns(), uninitialized);
 
-                MP.elements[MP_index + j] +=
-                    elements[index + k] *
-                        M.elements[M_index + j];
-            }
-        }
+    gemm(A.rows(), B.columns(), A.columns(),
+         A.data(), A.leading_dimension(),
+         B.data(), B.leading_dimension(),
+         MP.data(), MP.columns(), false);
+
+    return MP;
+}
+
+// * operator for matrix views, multiplies in place through gemm
+template<typename T, typename U>
+Matrix<typename Matrix_View<T>::value_type> operator * (const Matrix_View<T>& A,
+                                                        const Matrix_View<U>& B) {
+
+    return view_product<Matrix<typename Matrix_View<T>::value_type>>(A, B);
+}
+
+template<typename T, typename Alloc, typename U>
+Matrix<T, Alloc> operator * (const Matrix<T, Alloc>& A, const Matrix_View<U>& B) {
+
+    return view_product<Matrix<T, Alloc>>(A.view(), B);
+}
+
+template<typename T, typename U, typename Alloc>
+Matrix<U, Alloc> operator * (const Matrix_View<T>& A, const Matrix<U, Alloc>& B) {
+
+    return view_product<Matrix<U, Alloc>>(A, B.view());
+}
+
+// op(A) * op(B) written into a new matrix of type M, where op transposes
+// its operand for the flag 't' and leaves it alone for 'n'. transposes
+// are read in place by gemm
+template<typename M, typename T, typename U>
+M view_product(const Matrix_View<T>& A, const Matrix_View<U>& B, char trans_a, char trans_b) {
+
+    bool ta = gemm_transposed(trans_a);
+    bool tb = gemm_transposed(trans_b);
+
+    size_t m = ta ? A.columns() : A.rows();
+    size_t k = ta ? A.rows() : A.columns();
+    size_t n = tb ? B.rows() : B.columns();
+
+    if(k != (tb ? B.columns() : B.rows())) {
+
+        throw std::out_of_range("incorrect dimensions for a product");
     }
 
+    M MP(m, n, uninitialized);
+
+    gemm(trans_a, trans_b, m, n, k,
+         A.data(), A.leading_dimension(),
+         B.data(), B.leading_dimension(),
+         MP.data(), MP.columns(), false);
+
     return MP;
 }
 
+// op(A) * op(B) for views and for matrices, which keep their allocator
+template<typename T, typename U>
+Matrix<typename Matrix_View<T>::value_type> product(const Matrix_View<T>& A,
+                                                    const Matrix_View<U>& B,
+                                                    char trans_a, char trans_b) {
+
+    return view_product<Matrix<typename Matrix_View<T>::value_type>>(A, B, trans_a, trans_b);
+}
+
+template<typename T, typename Alloc>
+Matrix<T, Alloc> product(const Matrix<T, Alloc>& A, const Matrix<T, Alloc>& B,
+                         char trans_a, char trans_b) {
+
+    return view_product<Matrix<T, Alloc>>(A.view(), B.view(), trans_a, trans_b);
+}
+
+//*************************************************************************//
+//
+// products of matrix expressions
+//
+//*************************************************************************//
+
+// matrices are used in place, other expressions are evaluated once
+template<typename T, typename Alloc>
+const Matrix<T, Alloc>& materialize(const Matrix<T, Alloc>& M) { return M; }
+
+template<typename E>
+Matrix<typename E::value_type> materialize(const Matrix_Expression<E>& E_in) {
+
+    return Matrix<typename E::value_type>(E_in);
+}
+
+// * operator for matrix expressions
+template<typename L, typename R>
+Matrix<typename L::value_type> operator * (const Matrix_Expression<L>& l,
+                                           const Matrix_Expression<R>& r) {
+
+    const auto& ML = materialize(l.self());
+    const auto& MR = materialize(r.self());
+
+    return view_product<Matrix<typename L::value_type>>(ML.view(), MR.view());
+}
+
 //*************************************************************************//
 
 #endif // MATRIX_H_INCLUDED
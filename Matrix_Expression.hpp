@@ -0,0 +1,184 @@
+#ifndef MATRIX_EXPRESSION_H_INCLUDED
+#define MATRIX_EXPRESSION_H_INCLUDED
+
+//*************************************************************************//
+
+#include <memory>
+#include <stdexcept>
+
+//*************************************************************************//
+//
+// expression templates for matrix arithmetic
+//
+// A + B, A - B and s * A build lightweight expression objects instead of
+// matrices. nothing is computed until the expression is assigned to,
+// used to construct, or added into a Matrix, at which point every
+// element is produced in a single fused pass with no temporaries.
+//
+// expression objects refer to their matrix operands, so they should be
+// materialized before those matrices go out of scope.
+//
+//*************************************************************************//
+
+// the default allocator of Matrix is declared here, ahead of Matrix.hpp
+template<typename T, typename Alloc = std::allocator<T>>
+class Matrix;
+
+// base class tying an expression type to its interface
+template<typename E>
+struct Matrix_Expression {
+
+    const E& self() const { return static_cast<const E&>(*this); }
+
+};
+
+// matrices are held by reference, expression nodes by value
+template<typename E>
+struct Expression_Operand {
+
+    typedef const E type;
+};
+
+template<typename T, typename Alloc>
+struct Expression_Operand<Matrix<T, Alloc>> {
+
+    typedef const Matrix<T, Alloc>& type;
+};
+
+//*************************************************************************//
+//
+// expression nodes
+//
+//*************************************************************************//
+
+// element-wise sum
+template<typename L, typename R>
+class Matrix_Sum : public Matrix_Expression<Matrix_Sum<L, R>> {
+
+private:
+
+    typename Expression_Operand<L>::type left;
+    typename Expression_Operand<R>::type right;
+
+public:
+
+    typedef typename L::value_type value_type;
+
+    Matrix_Sum(const L& l, const R& r)
+
+        : left(l)
+        , right(r) {
+
+        if(left.rows() != right.rows() || left.columns() != right.columns()) {
+
+            throw std::out_of_range("dimensions do not match");
+        }
+    }
+
+    size_t rows() const { return left.rows(); }
+
+    size_t columns() const { return left.columns(); }
+
+    value_type operator () (size_t r, size_t c) const { return left(r, c) + right(r, c); }
+
+};
+
+// element-wise difference
+template<typename L, typename R>
+class Matrix_Difference : public Matrix_Expression<Matrix_Difference<L, R>> {
+
+private:
+
+    typename Expression_Operand<L>::type left;
+    typename Expression_Operand<R>::type right;
+
+public:
+
+    typedef typename L::value_type value_type;
+
+    Matrix_Difference(const L& l, const R& r)
+
+        : left(l)
+        , right(r) {
+
+        if(left.rows() != right.rows() || left.columns() != right.columns()) {
+
+            throw std::out_of_range("dimensions do not match");
+        }
+    }
+
+    size_t rows() const { return left.rows(); }
+
+    size_t columns() const { return left.columns(); }
+
+    value_type operator () (size_t r, size_t c) const { return left(r, c) - right(r, c); }
+
+};
+
+// scalar multiple
+template<typename E>
+class Matrix_Scaled : public Matrix_Expression<Matrix_Scaled<E>> {
+
+private:
+
+    typename Expression_Operand<E>::type operand;
+
+    typename E::value_type scalar;
+
+public:
+
+    typedef typename E::value_type value_type;
+
+    Matrix_Scaled(const E& e, const value_type& s)
+
+        : operand(e)
+        , scalar(s) {}
+
+    size_t rows() const { return operand.rows(); }
+
+    size_t columns() const { return operand.columns(); }
+
+    value_type operator () (size_t r, size_t c) const { return scalar * operand(r, c); }
+
+};
+
+//*************************************************************************//
+//
+// operators building expressions
+//
+//*************************************************************************//
+
+// + operator for matrix expressions
+template<typename L, typename R>
+Matrix_Sum<L, R> operator + (const Matrix_Expression<L>& l,
+                             const Matrix_Expression<R>& r) {
+
+    return Matrix_Sum<L, R>(l.self(), r.self());
+}
+
+// - operator for matrix expressions
+template<typename L, typename R>
+Matrix_Difference<L, R> operator - (const Matrix_Expression<L>& l,
+                                    const Matrix_Expression<R>& r) {
+
+    return Matrix_Difference<L, R>(l.self(), r.self());
+}
+
+// scalar * operators for matrix expressions
+template<typename E>
+Matrix_Scaled<E> operator * (const typename E::value_type& s,
+                             const Matrix_Expression<E>& e) {
+
+    return Matrix_Scaled<E>(e.self(), s);
+}
+
+template<typename E>
+Matrix_Scaled<E> operator * (const Matrix_Expression<E>& e,
+                             const typename E::value_type& s) {
+
+    return Matrix_Scaled<E>(e.self(), s);
+}
+
+//*************************************************************************//
+
+#endif // MATRIX_EXPRESSION_H_INCLUDED
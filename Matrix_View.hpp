@@ -0,0 +1,221 @@
+#ifndef MATRIX_VIEW_H_INCLUDED
+#define MATRIX_VIEW_H_INCLUDED
+
+//*************************************************************************//
+
+#include <type_traits>
+#include <stdexcept>
+
+#include "Matrix_Expression.hpp"
+
+//*************************************************************************//
+//
+// non-owning strided view of a rectangular block of a matrix
+//
+// a view is an origin pointer, extents and the leading dimension of the
+// storage it points into, so taking a view or a sub-view copies nothing.
+// Matrix_View<const T> gives read-only access. views do not keep their
+// matrix alive and are invalidated when it is reassigned or destroyed.
+//
+//*************************************************************************//
+
+template<typename T>
+class Matrix_View : public Matrix_Expression<Matrix_View<T>> {
+
+private:
+
+    // first element, extents and distance between rows
+    T* origin;
+
+    size_t n_rows, n_columns, leading;
+
+public:
+
+    // element type
+    typedef typename std::remove_const<T>::type value_type;
+
+    // constructor
+    Matrix_View(T*, size_t, size_t, size_t);
+
+    // read-only view of a writable view
+    template<typename U>
+    Matrix_View(const Matrix_View<U>&,
+                typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = 0);
+
+    // copy constructor and assigner rebind the view
+    Matrix_View(const Matrix_View&) = default;
+
+    Matrix_View& operator = (const Matrix_View&) = default;
+
+    // destructor
+    ~Matrix_View() = default;
+
+    // show number of rows
+    size_t rows() const;
+
+    // show number of columns
+    size_t columns() const;
+
+    // show distance between rows in the underlying storage
+    size_t leading_dimension() const;
+
+    // first element of the view
+    T* data() const;
+
+    // element access operator
+    T& operator () (size_t, size_t) const;
+
+    // sub-view of rows [row_a, row_b) and columns [column_a, column_b)
+    Matrix_View slice(size_t, size_t, size_t, size_t) const;
+
+    // copy an expression into the viewed elements
+    template<typename E>
+    const Matrix_View& assign(const Matrix_Expression<E>&) const;
+
+    // += operator for matrix expressions
+    template<typename E>
+    const Matrix_View& operator += (const Matrix_Expression<E>&) const;
+
+    // -= operator for matrix expressions
+    template<typename E>
+    const Matrix_View& operator -= (const Matrix_Expression<E>&) const;
+
+};
+
+//*************************************************************************//
+
+// constructor
+template<typename T>
+Matrix_View<T>::Matrix_View(T* o, size_t r, size_t c, size_t ld)
+
+    : origin(o)
+    , n_rows(r)
+    , n_columns(c)
+    , leading(ld) {}
+
+// read-only view of a writable view
+template<typename T>
+template<typename U>
+Matrix_View<T>::Matrix_View(const Matrix_View<U>& V,
+                            typename std::enable_if<std::is_convertible<U*, T*>::value>::type*)
+
+    : origin(V.data())
+    , n_rows(V.rows())
+    , n_columns(V.columns())
+    , leading(V.leading_dimension()) {}
+
+// show number of rows
+template<typename T>
+size_t Matrix_View<T>::rows() const { return n_rows; }
+
+// show number of columns
+template<typename T>
+size_t Matrix_View<T>::columns() const { return n_columns; }
+
+// show distance between rows in the underlying storage
+template<typename T>
+size_t Matrix_View<T>::leading_dimension() const { return leading; }
+
+// first element of the view
+template<typename T>
+T* Matrix_View<T>::data() const { return origin; }
+
+// element access operator
+template<typename T>
+T& Matrix_View<T>::operator () (size_t r, size_t c) const {
+
+    return origin[(r * leading) + c];
+}
+
+// sub-view
+template<typename T>
+Matrix_View<T> Matrix_View<T>::slice(size_t row_a, size_t row_b,
+                                     size_t column_a, size_t column_b) const {
+
+    if(row_a > row_b || row_b > n_rows || column_a > column_b || column_b > n_columns) {
+
+        throw std::out_of_range("index out of bounds");
+    }
+
+    return Matrix_View<T>(origin + (row_a * leading) + column_a,
+                          row_b - row_a, column_b - column_a, leading);
+}
+
+// copy an expression into the viewed elements
+template<typename T>
+template<typename E>
+const Matrix_View<T>& Matrix_View<T>::assign(const Matrix_Expression<E>& E_in) const {
+
+    const E& e = E_in.self();
+
+    if(n_rows != e.rows() || n_columns != e.columns()) {
+
+        throw std::out_of_range("dimensions do not match");
+    }
+
+    for(size_t i = 0; i < n_rows; ++i) {
+
+        T* row = origin + i * leading;
+
+        for(size_t j = 0; j < n_columns; ++j) {
+
+            row[j] = e(i, j);
+        }
+    }
+
+    return *this;
+}
+
+// += operator for matrix expressions
+template<typename T>
+template<typename E>
+const Matrix_View<T>& Matrix_View<T>::operator += (const Matrix_Expression<E>& E_in) const {
+
+    const E& e = E_in.self();
+
+    if(n_rows != e.rows() || n_columns != e.columns()) {
+
+        throw std::out_of_range("dimensions do not match");
+    }
+
+    for(size_t i = 0; i < n_rows; ++i) {
+
+        T* row = origin + i * leading;
+
+        for(size_t j = 0; j < n_columns; ++j) {
+
+            row[j] += e(i, j);
+        }
+    }
+
+    return *this;
+}
+
+// -= operator for matrix expressions
+template<typename T>
+template<typename E>
+const Matrix_View<T>& Matrix_View<T>::operator -= (const Matrix_Expression<E>& E_in) const {
+
+    const E& e = E_in.self();
+
+    if(n_rows != e.rows() || n_columns != e.columns()) {
+
+        throw std::out_of_range("dimensions do not match");
+    }
+
+    for(size_t i = 0; i < n_rows; ++i) {
+
+        T* row = origin + i * leading;
+
+        for(size_t j = 0; j < n_columns; ++j) {
+
+            row[j] -= e(i, j);
+        }
+    }
+
+    return *this;
+}
+
+//*************************************************************************//
+
+#endif // MATRIX_VIEW_H_INCLUDED
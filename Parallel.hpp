@@ -0,0 +1,432 @@
+#ifndef PARALLEL_H_INCLUDED
+#define PARALLEL_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <atomic>
+
+#include "Thread_Pool_Core.hpp"
+
+//*************************************************************************//
+//
+// parallel loops over a thread pool
+//
+// parallel_for calls body(begin, end) on pieces of first .. last, and
+// parallel_reduce calls body(begin, end, init) on the pieces and folds
+// their results with combine. a range is split in halves: the running
+// piece keeps the left half and hands the right half to the pool, where
+// idle workers steal it. splitting stops at grain indices or when the
+// piece has used up its depth, about four pieces per thread, and a
+// piece that was stolen gets more depth, so ranges are only cut finely
+// where workers run out of work. the calling thread runs the first
+// piece itself and helps the pool until every piece has finished, then
+// rethrows the first exception a body threw.
+//
+// with a Parallel_Affinity the range is cut into fixed pieces instead.
+// the affinity remembers which worker ran each piece, and the next loop
+// with the same affinity mails every piece to that worker, which finds
+// the piece's data still in its cache.
+//
+// halves are combined left before right, but where a range is split
+// depends on stealing, so a floating point reduction may round
+// differently from one run to the next.
+//
+//*************************************************************************//
+
+// splits a piece started by the caller may make
+inline size_t parallel_depth(const Thread_Pool_Core& pool) {
+
+    size_t depth = 0;
+
+    while((size_t(1) << depth) < 4 * (pool.size() + 1)) { ++depth; }
+
+    return depth;
+}
+
+// a grain of 0 allows pieces down to 1/64 of a share per thread
+inline size_t parallel_grain(size_t n, size_t grain, const Thread_Pool_Core& pool) {
+
+    return grain != 0 ? grain : n / (64 * (pool.size() + 1)) + 1;
+}
+
+// a piece of a parallel_for
+template<typename F>
+struct Parallel_For_Piece {
+
+    Thread_Pool_Core* pool;
+
+    std::shared_ptr<Pool_Latch> latch;
+
+    const F* body;
+
+    size_t first, last, grain, depth;
+
+    // thread that handed the piece to the pool
+    size_t spawner;
+
+    void operator()() {
+
+        size_t self = pool->worker_index();
+
+        // a stolen piece may be split again for the thieves behind it
+        if(self != spawner) { depth += 2; }
+
+        spawner = self;
+
+        while(last - first > grain && depth > 0) {
+
+            --depth;
+
+            size_t middle = first + (last - first) / 2;
+
+            Parallel_For_Piece right(*this);
+
+            right.first = middle;
+
+            last = middle;
+
+            latch->add(1);
+
+            try { pool->submit_front(pool_task(right)); }
+
+            catch(...) { latch->fail(std::current_exception()); latch->count_down(); }
+        }
+
+        try { (*body)(first, last); }
+
+        catch(...) { latch->fail(std::current_exception()); }
+
+        latch->count_down();
+    }
+};
+
+// call body(begin, end) on pieces of first .. last
+template<typename F>
+void parallel_for(Thread_Pool_Core& pool, size_t first, size_t last, size_t grain, const F& body) {
+
+    if(last <= first) { return; }
+
+    if(pool.size() == 0) { body(first, last); return; }
+
+    std::shared_ptr<Pool_Latch> latch = std::allocate_shared<Pool_Latch>(Pool_Allocator<Pool_Latch>(), 1);
+
+    Parallel_For_Piece<F> root = { &pool, latch, &body, first, last,
+                                   parallel_grain(last - first, grain, pool),
+                                   parallel_depth(pool), pool.worker_index() };
+
+    root();
+
+    Pool_Batch(latch, pool).wait_all();
+}
+
+//*************************************************************************//
+
+// state shared by the pieces of one parallel_reduce
+template<typename T, typename F, typename C>
+struct Parallel_Reduce_Control {
+
+    const F* body;
+
+    const C* combine;
+
+    T identity;
+
+    T result;
+};
+
+// a split waiting for the results of both halves
+template<typename T>
+struct Parallel_Join {
+
+    Parallel_Join* parent;
+
+    // which half of the parent this split is
+    size_t side;
+
+    T left, right;
+
+    std::atomic<int> pending;
+
+    Parallel_Join(Parallel_Join* p, size_t s, const T& identity)
+
+        : parent(p)
+        , side(s)
+        , left(identity)
+        , right(identity)
+        , pending(2) {}
+
+    static void* operator new(size_t size) { return pool_allocate(size); }
+
+    static void operator delete(void* p, size_t size) { pool_deallocate(p, size); }
+};
+
+// a piece of a parallel_reduce, its result goes to one side of a join
+template<typename T, typename F, typename C>
+struct Parallel_Reduce_Piece {
+
+    Thread_Pool_Core* pool;
+
+    std::shared_ptr<Pool_Latch> latch;
+
+    Parallel_Reduce_Control<T, F, C>* control;
+
+    Parallel_Join<T>* join;
+
+    size_t side;
+
+    size_t first, last, grain, depth;
+
+    size_t spawner;
+
+    // hand a result up the joins, the second half to arrive combines
+    void deliver(Parallel_Join<T>* to, size_t half, T value) {
+
+        while(to) {
+
+            (half == 0 ? to->left : to->right) = std::move(value);
+
+            if(to->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+
+            try { value = (*control->combine)(to->left, to->right); }
+
+            catch(...) { latch->fail(std::current_exception()); value = control->identity; }
+
+            Parallel_Join<T>* parent = to->parent;
+
+            half = to->side;
+
+            delete to;
+
+            to = parent;
+        }
+
+        control->result = std::move(value);
+    }
+
+    void operator()() {
+
+        size_t self = pool->worker_index();
+
+        if(self != spawner) { depth += 2; }
+
+        spawner = self;
+
+        try {
+
+            while(last - first > grain && depth > 0) {
+
+                --depth;
+
+                size_t middle = first + (last - first) / 2;
+
+                Parallel_Join<T>* split = new Parallel_Join<T>(join, side, control->identity);
+
+                Parallel_Reduce_Piece right(*this);
+
+                right.first = middle;
+                right.join = split;
+                right.side = 1;
+
+                join = split;
+                side = 0;
+                last = middle;
+
+                latch->add(1);
+
+                try { pool->submit_front(pool_task(right)); }
+
+                catch(...) {
+
+                    // the right half is lost, let its side of the join go
+                    latch->fail(std::current_exception());
+
+                    deliver(split, 1, control->identity);
+
+                    latch->count_down();
+                }
+            }
+
+        } catch(...) { latch->fail(std::current_exception()); }
+
+        T value = control->identity;
+
+        try { value = (*control->body)(first, last, value); }
+
+        catch(...) { latch->fail(std::current_exception()); value = control->identity; }
+
+        deliver(join, side, std::move(value));
+
+        latch->count_down();
+    }
+};
+
+// fold body(begin, end, init) over pieces of first .. last with combine,
+// starting every piece from identity
+template<typename T, typename F, typename C>
+T parallel_reduce(Thread_Pool_Core& pool, size_t first, size_t last, size_t grain,
+                  const T& identity, const F& body, const C& combine) {
+
+    if(last <= first) { return identity; }
+
+    if(pool.size() == 0) { return body(first, last, identity); }
+
+    Parallel_Reduce_Control<T, F, C> control = { &body, &combine, identity, identity };
+
+    std::shared_ptr<Pool_Latch> latch = std::allocate_shared<Pool_Latch>(Pool_Allocator<Pool_Latch>(), 1);
+
+    Parallel_Reduce_Piece<T, F, C> root = { &pool, latch, &control, 0, 0, first, last,
+                                            parallel_grain(last - first, grain, pool),
+                                            parallel_depth(pool), pool.worker_index() };
+
+    root();
+
+    Pool_Batch(latch, pool).wait_all();
+
+    return control.result;
+}
+
+//*************************************************************************//
+
+// the worker that last ran each piece of a parallel_for, reuse it for
+// loops over the same range to run every piece where it ran before
+struct Parallel_Affinity {
+
+    std::vector<size_t> owners;
+};
+
+// a fixed piece of an affine parallel_for
+template<typename F>
+struct Parallel_Affine_Piece {
+
+    Thread_Pool_Core* pool;
+
+    std::shared_ptr<Pool_Latch> latch;
+
+    const F* body;
+
+    size_t first, last;
+
+    // where the piece records the thread that ran it
+    size_t* owner;
+
+    void operator()() {
+
+        *owner = pool->worker_index();
+
+        try { (*body)(first, last); }
+
+        catch(...) { latch->fail(std::current_exception()); }
+
+        latch->count_down();
+    }
+};
+
+// call body(begin, end) on fixed pieces of first .. last, each sent to
+// the worker that ran it in the last loop with the same affinity
+template<typename F>
+void parallel_for(Thread_Pool_Core& pool, size_t first, size_t last, size_t grain,
+                  const F& body, Parallel_Affinity& affinity) {
+
+    if(last <= first) { return; }
+
+    if(pool.size() == 0) { body(first, last); return; }
+
+    size_t n = last - first;
+
+    grain = std::max<size_t>(grain, 1);
+
+    size_t pieces = std::min(4 * (pool.size() + 1), (n + grain - 1) / grain);
+
+    // a new range shape forgets the old owners
+    if(affinity.owners.size() != pieces) { affinity.owners.assign(pieces, size_t(-1)); }
+
+    std::shared_ptr<Pool_Latch> latch = std::allocate_shared<Pool_Latch>(Pool_Allocator<Pool_Latch>(), pieces);
+
+    size_t self = pool.worker_index();
+
+    std::vector<Parallel_Affine_Piece<F>> own;
+
+    std::vector<Pool_Task*> tasks;
+
+    std::vector<size_t> owners;
+
+    try {
+
+        for(size_t i = 0; i < pieces; ++i) {
+
+            Parallel_Affine_Piece<F> piece = { &pool, latch, &body, first + i * n / pieces,
+                                               first + (i + 1) * n / pieces, &affinity.owners[i] };
+
+            // the caller runs the pieces it ran before
+            if(affinity.owners[i] == self) { own.push_back(piece); continue; }
+
+            tasks.push_back(pool_task(piece));
+
+            owners.push_back(affinity.owners[i]);
+        }
+
+    } catch(...) {
+
+        for(size_t i = 0; i < tasks.size(); ++i) { delete tasks[i]; }
+
+        throw;
+    }
+
+    pool.submit_affine(owners.data(), tasks.data(), tasks.size());
+
+    for(size_t i = 0; i < own.size(); ++i) { own[i](); }
+
+    Pool_Batch(latch, pool).wait_all();
+}
+
+//*************************************************************************//
+//
+// the library's own loops
+//
+// element-wise Matrix operations run on one shared pool once they touch
+// parallel_threshold elements. the pool has a worker for every hardware
+// thread but the calling one, which helps, and is only started by the
+// first loop large enough to use it. operations inside tasks of another
+// pool stay serial, so a parallel product does not oversubscribe.
+//
+//*************************************************************************//
+
+const size_t parallel_threshold = size_t(1) << 18;
+
+inline size_t parallel_workers() {
+
+    return std::max(1u, std::thread::hardware_concurrency()) - 1;
+}
+
+inline Thread_Pool_Core& parallel_pool() {
+
+    static Thread_Pool_Core pool(parallel_workers(), 'f');
+
+    return pool;
+}
+
+// body(first, last) over rows of width elements each, on the shared
+// pool for at least parallel_threshold elements, else on the caller. a
+// caller that is already a task of some pool runs the rows itself, its
+// pool keeps the machine busy
+template<typename F>
+void parallel_rows(size_t rows, size_t width, const F& body) {
+
+    if(rows * width < parallel_threshold || parallel_workers() == 0 || Thread_Pool_Core::in_task()) {
+
+        body(0, rows);
+
+        return;
+    }
+
+    parallel_for(parallel_pool(), 0, rows, (size_t(1) << 14) / std::max<size_t>(width, 1) + 1, body);
+}
+
+//*************************************************************************//
+
+#endif // PARALLEL_H_INCLUDED
@@ -0,0 +1,988 @@
+#ifndef SIMD_H_INCLUDED
+#define SIMD_H_INCLUDED
+
+//*************************************************************************//
+
+#include <complex>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#include <cpuid.h>
+#else
+#define SIMD_X86 0
+#endif
+
+//*************************************************************************//
+//
+// runtime dispatched SIMD kernels
+//
+// the instruction set is detected once through CPUID and the matching
+// kernels are bound into a function table, so a single binary uses
+// SSE2, AVX2 or AVX-512 depending on the host it runs on. setting the
+// environment variable MATRIX_SIMD to scalar, sse2, avx2 or avx512 caps
+// the level that is used.
+//
+//*************************************************************************//
+
+enum Simd_Level { simd_scalar, simd_sse2, simd_avx2, simd_avx512 };
+
+// register tiles of the gemm micro-kernels, shared by every level
+// so that one packing layout serves all of them
+const size_t simd_mr = 6;
+const size_t simd_nr_double = 8;
+const size_t simd_nr_float = 16;
+
+//*************************************************************************//
+//
+// host detection
+//
+//*************************************************************************//
+
+#if SIMD_X86
+
+// read the extended control register through xgetbv
+inline unsigned long long simd_xgetbv() {
+
+    unsigned int eax, edx;
+
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+
+#endif
+
+// highest level supported by both the processor and the operating system
+inline Simd_Level simd_detect() {
+
+    Simd_Level level = simd_scalar;
+
+#if SIMD_X86
+
+    unsigned int eax, ebx, ecx, edx;
+
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return level; }
+
+    if(edx & bit_SSE2) { level = simd_sse2; }
+
+    bool os_saves_ymm = false;
+    bool os_saves_zmm = false;
+
+    if(ecx & bit_OSXSAVE) {
+
+        unsigned long long xcr0 = simd_xgetbv();
+
+        os_saves_ymm = (xcr0 & 0x06) == 0x06;
+        os_saves_zmm = (xcr0 & 0xe6) == 0xe6;
+    }
+
+    bool avx = (ecx & bit_AVX) != 0;
+    bool fma = (ecx & bit_FMA) != 0;
+
+    if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+
+        if(os_saves_ymm && avx && fma && (ebx & bit_AVX2)) { level = simd_avx2; }
+
+        if(os_saves_zmm && level == simd_avx2 && (ebx & bit_AVX512F)) { level = simd_avx512; }
+    }
+#endif
+
+    // optional cap from the environment
+    const char* cap = std::getenv("MATRIX_SIMD");
+
+    if(cap) {
+
+        Simd_Level limit = level;
+
+        if(std::strcmp(cap, "scalar") == 0) { limit = simd_scalar; }
+        else if(std::strcmp(cap, "sse2") == 0) { limit = simd_sse2; }
+        else if(std::strcmp(cap, "avx2") == 0) { limit = simd_avx2; }
+        else if(std::strcmp(cap, "avx512") == 0) { limit = simd_avx512; }
+
+        if(limit < level) { level = limit; }
+    }
+
+    return level;
+}
+
+// level used by this process, detected on first use
+inline Simd_Level simd_level() {
+
+    static const Simd_Level level = simd_detect();
+
+    return level;
+}
+
+//*************************************************************************//
+//
+// scalar kernels
+//
+//*************************************************************************//
+
+struct Simd_Scalar {
+
+    template<typename T>
+    static void add(T* a, const T* b, size_t n) {
+
+        for(size_t i = 0; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    template<typename T>
+    static void subtract(T* a, const T* b, size_t n) {
+
+        for(size_t i = 0; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    template<typename T>
+    static bool equal(const T* a, const T* b, size_t n) {
+
+        for(size_t i = 0; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    template<typename T>
+    static void round_down(T* a, size_t n, T r) {
+
+        for(size_t i = 0; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+};
+
+#if SIMD_X86
+
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+
+//*************************************************************************//
+//
+// SSE2 kernels
+//
+//*************************************************************************//
+
+struct Simd_Sse2 {
+
+    SIMD_TARGET_SSE2
+    static void add(double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 2 <= n; i += 2) {
+
+            _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    SIMD_TARGET_SSE2
+    static void add(float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            _mm_storeu_ps(a + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    SIMD_TARGET_SSE2
+    static void subtract(double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 2 <= n; i += 2) {
+
+            _mm_storeu_pd(a + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    SIMD_TARGET_SSE2
+    static void subtract(float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            _mm_storeu_ps(a + i, _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    SIMD_TARGET_SSE2
+    static bool equal(const double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 2 <= n; i += 2) {
+
+            __m128d eq = _mm_cmpeq_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+
+            if(_mm_movemask_pd(eq) != 0x3) { return false; }
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    SIMD_TARGET_SSE2
+    static bool equal(const float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            __m128 eq = _mm_cmpeq_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+
+            if(_mm_movemask_ps(eq) != 0xf) { return false; }
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    SIMD_TARGET_SSE2
+    static void round_down(double* a, size_t n, double r) {
+
+        __m128d upper = _mm_set1_pd(r);
+        __m128d lower = _mm_set1_pd(-r);
+
+        size_t i = 0;
+
+        for(; i + 2 <= n; i += 2) {
+
+            __m128d x = _mm_loadu_pd(a + i);
+            __m128d small = _mm_and_pd(_mm_cmpgt_pd(x, lower), _mm_cmplt_pd(x, upper));
+
+            _mm_storeu_pd(a + i, _mm_andnot_pd(small, x));
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+    SIMD_TARGET_SSE2
+    static void round_down(float* a, size_t n, float r) {
+
+        __m128 upper = _mm_set1_ps(r);
+        __m128 lower = _mm_set1_ps(-r);
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            __m128 x = _mm_loadu_ps(a + i);
+            __m128 small = _mm_and_ps(_mm_cmpgt_ps(x, lower), _mm_cmplt_ps(x, upper));
+
+            _mm_storeu_ps(a + i, _mm_andnot_ps(small, x));
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+    // 6 x 8 double micro-kernel, done as two 6 x 4 halves to fit 16 registers
+    SIMD_TARGET_SSE2
+    static void micro_kernel(size_t kc, const double* a, const double* b,
+                             double* ab) {
+
+        for(size_t half = 0; half < 2; ++half) {
+
+            __m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+            __m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+            __m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+            __m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+            __m128d c40 = _mm_setzero_pd(), c41 = _mm_setzero_pd();
+            __m128d c50 = _mm_setzero_pd(), c51 = _mm_setzero_pd();
+
+            const double* pa = a;
+            const double* pb = b + 4 * half;
+
+            for(size_t p = 0; p < kc; ++p) {
+
+                __m128d b0 = _mm_loadu_pd(pb);
+                __m128d b1 = _mm_loadu_pd(pb + 2);
+                __m128d x;
+
+                x = _mm_set1_pd(pa[0]);
+                c00 = _mm_add_pd(c00, _mm_mul_pd(x, b0)); c01 = _mm_add_pd(c01, _mm_mul_pd(x, b1));
+                x = _mm_set1_pd(pa[1]);
+                c10 = _mm_add_pd(c10, _mm_mul_pd(x, b0)); c11 = _mm_add_pd(c11, _mm_mul_pd(x, b1));
+                x = _mm_set1_pd(pa[2]);
+                c20 = _mm_add_pd(c20, _mm_mul_pd(x, b0)); c21 = _mm_add_pd(c21, _mm_mul_pd(x, b1));
+                x = _mm_set1_pd(pa[3]);
+                c30 = _mm_add_pd(c30, _mm_mul_pd(x, b0)); c31 = _mm_add_pd(c31, _mm_mul_pd(x, b1));
+                x = _mm_set1_pd(pa[4]);
+                c40 = _mm_add_pd(c40, _mm_mul_pd(x, b0)); c41 = _mm_add_pd(c41, _mm_mul_pd(x, b1));
+                x = _mm_set1_pd(pa[5]);
+                c50 = _mm_add_pd(c50, _mm_mul_pd(x, b0)); c51 = _mm_add_pd(c51, _mm_mul_pd(x, b1));
+
+                pa += simd_mr;
+                pb += simd_nr_double;
+            }
+
+            double* out = ab + 4 * half;
+
+            _mm_storeu_pd(out + 0 * 8, c00); _mm_storeu_pd(out + 0 * 8 + 2, c01);
+            _mm_storeu_pd(out + 1 * 8, c10); _mm_storeu_pd(out + 1 * 8 + 2, c11);
+            _mm_storeu_pd(out + 2 * 8, c20); _mm_storeu_pd(out + 2 * 8 + 2, c21);
+            _mm_storeu_pd(out + 3 * 8, c30); _mm_storeu_pd(out + 3 * 8 + 2, c31);
+            _mm_storeu_pd(out + 4 * 8, c40); _mm_storeu_pd(out + 4 * 8 + 2, c41);
+            _mm_storeu_pd(out + 5 * 8, c50); _mm_storeu_pd(out + 5 * 8 + 2, c51);
+        }
+    }
+
+    // 6 x 16 float micro-kernel, done as two 6 x 8 halves to fit 16 registers
+    SIMD_TARGET_SSE2
+    static void micro_kernel(size_t kc, const float* a, const float* b,
+                             float* ab) {
+
+        for(size_t half = 0; half < 2; ++half) {
+
+            __m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+            __m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+            __m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+            __m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+            __m128 c40 = _mm_setzero_ps(), c41 = _mm_setzero_ps();
+            __m128 c50 = _mm_setzero_ps(), c51 = _mm_setzero_ps();
+
+            const float* pa = a;
+            const float* pb = b + 8 * half;
+
+            for(size_t p = 0; p < kc; ++p) {
+
+                __m128 b0 = _mm_loadu_ps(pb);
+                __m128 b1 = _mm_loadu_ps(pb + 4);
+                __m128 x;
+
+                x = _mm_set1_ps(pa[0]);
+                c00 = _mm_add_ps(c00, _mm_mul_ps(x, b0)); c01 = _mm_add_ps(c01, _mm_mul_ps(x, b1));
+                x = _mm_set1_ps(pa[1]);
+                c10 = _mm_add_ps(c10, _mm_mul_ps(x, b0)); c11 = _mm_add_ps(c11, _mm_mul_ps(x, b1));
+                x = _mm_set1_ps(pa[2]);
+                c20 = _mm_add_ps(c20, _mm_mul_ps(x, b0)); c21 = _mm_add_ps(c21, _mm_mul_ps(x, b1));
+                x = _mm_set1_ps(pa[3]);
+                c30 = _mm_add_ps(c30, _mm_mul_ps(x, b0)); c31 = _mm_add_ps(c31, _mm_mul_ps(x, b1));
+                x = _mm_set1_ps(pa[4]);
+                c40 = _mm_add_ps(c40, _mm_mul_ps(x, b0)); c41 = _mm_add_ps(c41, _mm_mul_ps(x, b1));
+                x = _mm_set1_ps(pa[5]);
+                c50 = _mm_add_ps(c50, _mm_mul_ps(x, b0)); c51 = _mm_add_ps(c51, _mm_mul_ps(x, b1));
+
+                pa += simd_mr;
+                pb += simd_nr_float;
+            }
+
+            float* out = ab + 8 * half;
+
+            _mm_storeu_ps(out + 0 * 16, c00); _mm_storeu_ps(out + 0 * 16 + 4, c01);
+            _mm_storeu_ps(out + 1 * 16, c10); _mm_storeu_ps(out + 1 * 16 + 4, c11);
+            _mm_storeu_ps(out + 2 * 16, c20); _mm_storeu_ps(out + 2 * 16 + 4, c21);
+            _mm_storeu_ps(out + 3 * 16, c30); _mm_storeu_ps(out + 3 * 16 + 4, c31);
+            _mm_storeu_ps(out + 4 * 16, c40); _mm_storeu_ps(out + 4 * 16 + 4, c41);
+            _mm_storeu_ps(out + 5 * 16, c50); _mm_storeu_ps(out + 5 * 16 + 4, c51);
+        }
+    }
+
+};
+
+//*************************************************************************//
+//
+// AVX2 kernels
+//
+//*************************************************************************//
+
+struct Simd_Avx2 {
+
+    SIMD_TARGET_AVX2
+    static void add(double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    SIMD_TARGET_AVX2
+    static void add(float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            _mm256_storeu_ps(a + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    SIMD_TARGET_AVX2
+    static void subtract(double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            _mm256_storeu_pd(a + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    SIMD_TARGET_AVX2
+    static void subtract(float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            _mm256_storeu_ps(a + i, _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    SIMD_TARGET_AVX2
+    static bool equal(const double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            __m256d eq = _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), _CMP_EQ_OQ);
+
+            if(_mm256_movemask_pd(eq) != 0xf) { return false; }
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    SIMD_TARGET_AVX2
+    static bool equal(const float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            __m256 eq = _mm256_cmp_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), _CMP_EQ_OQ);
+
+            if(_mm256_movemask_ps(eq) != 0xff) { return false; }
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    SIMD_TARGET_AVX2
+    static void round_down(double* a, size_t n, double r) {
+
+        __m256d upper = _mm256_set1_pd(r);
+        __m256d lower = _mm256_set1_pd(-r);
+
+        size_t i = 0;
+
+        for(; i + 4 <= n; i += 4) {
+
+            __m256d x = _mm256_loadu_pd(a + i);
+            __m256d small = _mm256_and_pd(_mm256_cmp_pd(x, lower, _CMP_GT_OQ),
+                                          _mm256_cmp_pd(x, upper, _CMP_LT_OQ));
+
+            _mm256_storeu_pd(a + i, _mm256_andnot_pd(small, x));
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+    SIMD_TARGET_AVX2
+    static void round_down(float* a, size_t n, float r) {
+
+        __m256 upper = _mm256_set1_ps(r);
+        __m256 lower = _mm256_set1_ps(-r);
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            __m256 x = _mm256_loadu_ps(a + i);
+            __m256 small = _mm256_and_ps(_mm256_cmp_ps(x, lower, _CMP_GT_OQ),
+                                         _mm256_cmp_ps(x, upper, _CMP_LT_OQ));
+
+            _mm256_storeu_ps(a + i, _mm256_andnot_ps(small, x));
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+    // 6 x 8 double micro-kernel, two ymm accumulators per row
+    SIMD_TARGET_AVX2
+    static void micro_kernel(size_t kc, const double* a, const double* b,
+                             double* ab) {
+
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+        __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+        for(size_t p = 0; p < kc; ++p) {
+
+            __m256d b0 = _mm256_loadu_pd(b);
+            __m256d b1 = _mm256_loadu_pd(b + 4);
+            __m256d x;
+
+            x = _mm256_broadcast_sd(a + 0);
+            c00 = _mm256_fmadd_pd(x, b0, c00); c01 = _mm256_fmadd_pd(x, b1, c01);
+            x = _mm256_broadcast_sd(a + 1);
+            c10 = _mm256_fmadd_pd(x, b0, c10); c11 = _mm256_fmadd_pd(x, b1, c11);
+            x = _mm256_broadcast_sd(a + 2);
+            c20 = _mm256_fmadd_pd(x, b0, c20); c21 = _mm256_fmadd_pd(x, b1, c21);
+            x = _mm256_broadcast_sd(a + 3);
+            c30 = _mm256_fmadd_pd(x, b0, c30); c31 = _mm256_fmadd_pd(x, b1, c31);
+            x = _mm256_broadcast_sd(a + 4);
+            c40 = _mm256_fmadd_pd(x, b0, c40); c41 = _mm256_fmadd_pd(x, b1, c41);
+            x = _mm256_broadcast_sd(a + 5);
+            c50 = _mm256_fmadd_pd(x, b0, c50); c51 = _mm256_fmadd_pd(x, b1, c51);
+
+            a += simd_mr;
+            b += simd_nr_double;
+        }
+
+        _mm256_storeu_pd(ab + 0 * 8, c00); _mm256_storeu_pd(ab + 0 * 8 + 4, c01);
+        _mm256_storeu_pd(ab + 1 * 8, c10); _mm256_storeu_pd(ab + 1 * 8 + 4, c11);
+        _mm256_storeu_pd(ab + 2 * 8, c20); _mm256_storeu_pd(ab + 2 * 8 + 4, c21);
+        _mm256_storeu_pd(ab + 3 * 8, c30); _mm256_storeu_pd(ab + 3 * 8 + 4, c31);
+        _mm256_storeu_pd(ab + 4 * 8, c40); _mm256_storeu_pd(ab + 4 * 8 + 4, c41);
+        _mm256_storeu_pd(ab + 5 * 8, c50); _mm256_storeu_pd(ab + 5 * 8 + 4, c51);
+    }
+
+    // 6 x 16 float micro-kernel, two ymm accumulators per row
+    SIMD_TARGET_AVX2
+    static void micro_kernel(size_t kc, const float* a, const float* b,
+                             float* ab) {
+
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+        __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+        __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+        __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+        for(size_t p = 0; p < kc; ++p) {
+
+            __m256 b0 = _mm256_loadu_ps(b);
+            __m256 b1 = _mm256_loadu_ps(b + 8);
+            __m256 x;
+
+            x = _mm256_broadcast_ss(a + 0);
+            c00 = _mm256_fmadd_ps(x, b0, c00); c01 = _mm256_fmadd_ps(x, b1, c01);
+            x = _mm256_broadcast_ss(a + 1);
+            c10 = _mm256_fmadd_ps(x, b0, c10); c11 = _mm256_fmadd_ps(x, b1, c11);
+            x = _mm256_broadcast_ss(a + 2);
+            c20 = _mm256_fmadd_ps(x, b0, c20); c21 = _mm256_fmadd_ps(x, b1, c21);
+            x = _mm256_broadcast_ss(a + 3);
+            c30 = _mm256_fmadd_ps(x, b0, c30); c31 = _mm256_fmadd_ps(x, b1, c31);
+            x = _mm256_broadcast_ss(a + 4);
+            c40 = _mm256_fmadd_ps(x, b0, c40); c41 = _mm256_fmadd_ps(x, b1, c41);
+            x = _mm256_broadcast_ss(a + 5);
+            c50 = _mm256_fmadd_ps(x, b0, c50); c51 = _mm256_fmadd_ps(x, b1, c51);
+
+            a += simd_mr;
+            b += simd_nr_float;
+        }
+
+        _mm256_storeu_ps(ab + 0 * 16, c00); _mm256_storeu_ps(ab + 0 * 16 + 8, c01);
+        _mm256_storeu_ps(ab + 1 * 16, c10); _mm256_storeu_ps(ab + 1 * 16 + 8, c11);
+        _mm256_storeu_ps(ab + 2 * 16, c20); _mm256_storeu_ps(ab + 2 * 16 + 8, c21);
+        _mm256_storeu_ps(ab + 3 * 16, c30); _mm256_storeu_ps(ab + 3 * 16 + 8, c31);
+        _mm256_storeu_ps(ab + 4 * 16, c40); _mm256_storeu_ps(ab + 4 * 16 + 8, c41);
+        _mm256_storeu_ps(ab + 5 * 16, c50); _mm256_storeu_ps(ab + 5 * 16 + 8, c51);
+    }
+
+};
+
+//*************************************************************************//
+//
+// AVX-512 kernels
+//
+//*************************************************************************//
+
+struct Simd_Avx512 {
+
+    SIMD_TARGET_AVX512
+    static void add(double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            _mm512_storeu_pd(a + i, _mm512_add_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    SIMD_TARGET_AVX512
+    static void add(float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 16 <= n; i += 16) {
+
+            _mm512_storeu_ps(a + i, _mm512_add_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] += b[i]; }
+    }
+
+    SIMD_TARGET_AVX512
+    static void subtract(double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            _mm512_storeu_pd(a + i, _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    SIMD_TARGET_AVX512
+    static void subtract(float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 16 <= n; i += 16) {
+
+            _mm512_storeu_ps(a + i, _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+        }
+
+        for(; i < n; ++i) { a[i] -= b[i]; }
+    }
+
+    SIMD_TARGET_AVX512
+    static bool equal(const double* a, const double* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            __mmask8 eq = _mm512_cmp_pd_mask(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), _CMP_EQ_OQ);
+
+            if(eq != 0xff) { return false; }
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    SIMD_TARGET_AVX512
+    static bool equal(const float* a, const float* b, size_t n) {
+
+        size_t i = 0;
+
+        for(; i + 16 <= n; i += 16) {
+
+            __mmask16 eq = _mm512_cmp_ps_mask(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), _CMP_EQ_OQ);
+
+            if(eq != 0xffff) { return false; }
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] != b[i]) { return false; }
+        }
+
+        return true;
+    }
+
+    SIMD_TARGET_AVX512
+    static void round_down(double* a, size_t n, double r) {
+
+        __m512d upper = _mm512_set1_pd(r);
+        __m512d lower = _mm512_set1_pd(-r);
+
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+
+            __m512d x = _mm512_loadu_pd(a + i);
+            __mmask8 large = ~(_mm512_cmp_pd_mask(x, lower, _CMP_GT_OQ) &
+                               _mm512_cmp_pd_mask(x, upper, _CMP_LT_OQ));
+
+            _mm512_storeu_pd(a + i, _mm512_maskz_mov_pd(large, x));
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+    SIMD_TARGET_AVX512
+    static void round_down(float* a, size_t n, float r) {
+
+        __m512 upper = _mm512_set1_ps(r);
+        __m512 lower = _mm512_set1_ps(-r);
+
+        size_t i = 0;
+
+        for(; i + 16 <= n; i += 16) {
+
+            __m512 x = _mm512_loadu_ps(a + i);
+            __mmask16 large = ~(_mm512_cmp_ps_mask(x, lower, _CMP_GT_OQ) &
+                                _mm512_cmp_ps_mask(x, upper, _CMP_LT_OQ));
+
+            _mm512_storeu_ps(a + i, _mm512_maskz_mov_ps(large, x));
+        }
+
+        for(; i < n; ++i) {
+
+            if(a[i] > -r && a[i] < r) { a[i] = 0; }
+        }
+    }
+
+    // 6 x 8 double micro-kernel, one zmm accumulator per row
+    SIMD_TARGET_AVX512
+    static void micro_kernel(size_t kc, const double* a, const double* b,
+                             double* ab) {
+
+        __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+        __m512d c2 = _mm512_setzero_pd(), c3 = _mm512_setzero_pd();
+        __m512d c4 = _mm512_setzero_pd(), c5 = _mm512_setzero_pd();
+
+        for(size_t p = 0; p < kc; ++p) {
+
+            __m512d b0 = _mm512_loadu_pd(b);
+
+            c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[0]), b0, c0);
+            c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[1]), b0, c1);
+            c2 = _mm512_fmadd_pd(_mm512_set1_pd(a[2]), b0, c2);
+            c3 = _mm512_fmadd_pd(_mm512_set1_pd(a[3]), b0, c3);
+            c4 = _mm512_fmadd_pd(_mm512_set1_pd(a[4]), b0, c4);
+            c5 = _mm512_fmadd_pd(_mm512_set1_pd(a[5]), b0, c5);
+
+            a += simd_mr;
+            b += simd_nr_double;
+        }
+
+        _mm512_storeu_pd(ab + 0 * 8, c0);
+        _mm512_storeu_pd(ab + 1 * 8, c1);
+        _mm512_storeu_pd(ab + 2 * 8, c2);
+        _mm512_storeu_pd(ab + 3 * 8, c3);
+        _mm512_storeu_pd(ab + 4 * 8, c4);
+        _mm512_storeu_pd(ab + 5 * 8, c5);
+    }
+
+    // 6 x 16 float micro-kernel, one zmm accumulator per row
+    SIMD_TARGET_AVX512
+    static void micro_kernel(size_t kc, const float* a, const float* b,
+                             float* ab) {
+
+        __m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps();
+        __m512 c2 = _mm512_setzero_ps(), c3 = _mm512_setzero_ps();
+        __m512 c4 = _mm512_setzero_ps(), c5 = _mm512_setzero_ps();
+
+        for(size_t p = 0; p < kc; ++p) {
+
+            __m512 b0 = _mm512_loadu_ps(b);
+
+            c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), b0, c0);
+            c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), b0, c1);
+            c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), b0, c2);
+            c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), b0, c3);
+            c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), b0, c4);
+            c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), b0, c5);
+
+            a += simd_mr;
+            b += simd_nr_float;
+        }
+
+        _mm512_storeu_ps(ab + 0 * 16, c0);
+        _mm512_storeu_ps(ab + 1 * 16, c1);
+        _mm512_storeu_ps(ab + 2 * 16, c2);
+        _mm512_storeu_ps(ab + 3 * 16, c3);
+        _mm512_storeu_ps(ab + 4 * 16, c4);
+        _mm512_storeu_ps(ab + 5 * 16, c5);
+    }
+
+};
+
+#endif // SIMD_X86
+
+//*************************************************************************//
+//
+// function tables bound once per value type
+//
+//*************************************************************************//
+
+template<typename T>
+struct Simd_Kernels {
+
+    void (*add)(T*, const T*, size_t);
+    void (*subtract)(T*, const T*, size_t);
+    bool (*equal)(const T*, const T*, size_t);
+    void (*round_down)(T*, size_t, T);
+
+    // writes an mr x nr tile of packed A times packed B, or is null
+    // when the generic gemm micro-kernel should be used
+    void (*micro_kernel)(size_t, const T*, const T*, T*);
+
+    template<typename K>
+    void bind() {
+
+        add = &K::add;
+        subtract = &K::subtract;
+        equal = &K::equal;
+        round_down = &K::round_down;
+        micro_kernel = &K::micro_kernel;
+    }
+
+    Simd_Kernels() {
+
+        add = &Simd_Scalar::add<T>;
+        subtract = &Simd_Scalar::subtract<T>;
+        equal = &Simd_Scalar::equal<T>;
+        round_down = &Simd_Scalar::round_down<T>;
+        micro_kernel = 0;
+
+#if SIMD_X86
+        switch(simd_level()) {
+
+            case simd_avx512: bind<Simd_Avx512>(); break;
+            case simd_avx2: bind<Simd_Avx2>(); break;
+            case simd_sse2: bind<Simd_Sse2>(); break;
+            default: break;
+        }
+#endif
+    }
+
+    static const Simd_Kernels& host() {
+
+        static const Simd_Kernels kernels;
+
+        return kernels;
+    }
+};
+
+//*************************************************************************//
+//
+// element-wise entry points
+//
+// float and double go through the function tables, complex values are
+// handed over as interleaved real and imaginary parts, and every other
+// type uses the scalar loops
+//
+//*************************************************************************//
+
+// a += b
+template<typename T>
+inline void simd_add(T* a, const T* b, size_t n) { Simd_Scalar::add(a, b, n); }
+
+inline void simd_add(double* a, const double* b, size_t n) { Simd_Kernels<double>::host().add(a, b, n); }
+
+inline void simd_add(float* a, const float* b, size_t n) { Simd_Kernels<float>::host().add(a, b, n); }
+
+template<typename T>
+inline void simd_add(std::complex<T>* a, const std::complex<T>* b, size_t n) {
+
+    simd_add(reinterpret_cast<T*>(a), reinterpret_cast<const T*>(b), 2 * n);
+}
+
+// a -= b
+template<typename T>
+inline void simd_subtract(T* a, const T* b, size_t n) { Simd_Scalar::subtract(a, b, n); }
+
+inline void simd_subtract(double* a, const double* b, size_t n) { Simd_Kernels<double>::host().subtract(a, b, n); }
+
+inline void simd_subtract(float* a, const float* b, size_t n) { Simd_Kernels<float>::host().subtract(a, b, n); }
+
+template<typename T>
+inline void simd_subtract(std::complex<T>* a, const std::complex<T>* b, size_t n) {
+
+    simd_subtract(reinterpret_cast<T*>(a), reinterpret_cast<const T*>(b), 2 * n);
+}
+
+// a == b
+template<typename T>
+inline bool simd_equal(const T* a, const T* b, size_t n) { return Simd_Scalar::equal(a, b, n); }
+
+inline bool simd_equal(const double* a, const double* b, size_t n) { return Simd_Kernels<double>::host().equal(a, b, n); }
+
+inline bool simd_equal(const float* a, const float* b, size_t n) { return Simd_Kernels<float>::host().equal(a, b, n); }
+
+template<typename T>
+inline bool simd_equal(const std::complex<T>* a, const std::complex<T>* b, size_t n) {
+
+    return simd_equal(reinterpret_cast<const T*>(a), reinterpret_cast<const T*>(b), 2 * n);
+}
+
+// values strictly between -r and r become zero
+template<typename T>
+inline void simd_round_down(T* a, size_t n, T r) { Simd_Scalar::round_down(a, n, r); }
+
+inline void simd_round_down(double* a, size_t n, double r) { Simd_Kernels<double>::host().round_down(a, n, r); }
+
+inline void simd_round_down(float* a, size_t n, float r) { Simd_Kernels<float>::host().round_down(a, n, r); }
+
+// real and imaginary parts are rounded independently
+template<typename T>
+inline void simd_round_down(std::complex<T>* a, size_t n, T r) {
+
+    simd_round_down(reinterpret_cast<T*>(a), 2 * n, r);
+}
+
+//*************************************************************************//
+
+#endif // SIMD_H_INCLUDED
@@ -0,0 +1,478 @@
+#ifndef SPARSE_MATRIX_H_INCLUDED
+#define SPARSE_MATRIX_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Matrix.hpp"
+
+//*************************************************************************//
+//
+// compressed sparse matrix class
+//
+// only nonzero elements are stored, in compressed sparse row ('r') or
+// compressed sparse column ('c') order. for CSR, offsets[i] ...
+// offsets[i + 1] - 1 index the values and column indices of row i; CSC
+// is the same with rows and columns exchanged.
+//
+// products with dense matrices skip every zero, so for the matrices of
+// large systems, which are mostly zeros, they do a small fraction of the
+// work of a dense product. test_Sparse_Matrix shows where dense wins.
+//
+//*************************************************************************//
+
+template<typename T>
+class Sparse_Matrix {
+
+private:
+
+    // rows, columns
+    size_t n_rows, n_columns;
+
+    // 'r' for compressed rows, 'c' for compressed columns
+    char order;
+
+    // start of each compressed row or column, with the total at the end
+    std::vector<size_t> offsets;
+
+    // column of each value for CSR, row of each value for CSC
+    std::vector<size_t> indices;
+
+    // nonzero values
+    std::vector<T> values;
+
+    // rows [first, last) of a CSR product, C = A * B
+    template<typename Alloc>
+    void row_product(size_t, size_t, const Matrix<T, Alloc>&, Matrix<T>&) const;
+
+    // columns [first, last) of B in a CSC product, C = A * B
+    template<typename Alloc>
+    void column_product(size_t, size_t, const Matrix<T, Alloc>&, Matrix<T>&) const;
+
+public:
+
+    // element type
+    typedef T value_type;
+
+//*************************************************************************//
+//
+// constructors, destructor, assignment operators and member functions
+//
+//*************************************************************************//
+
+    // empty constructor, every element zero
+    Sparse_Matrix(size_t, size_t, char = 'r');
+
+    // dense constructor, keeps the elements that are not zero
+    template<typename Alloc>
+    explicit Sparse_Matrix(const Matrix<T, Alloc>&, char = 'r');
+
+    // compressed constructor from offsets, indices and values
+    Sparse_Matrix(size_t, size_t, char,
+                  std::vector<size_t>, std::vector<size_t>, std::vector<T>);
+
+    // move and copy constructors
+    Sparse_Matrix(Sparse_Matrix&&) = default;
+
+    Sparse_Matrix(const Sparse_Matrix&) = default;
+
+    // move and copy assigners
+    Sparse_Matrix& operator = (Sparse_Matrix&&) = default;
+
+    Sparse_Matrix& operator = (const Sparse_Matrix&) = default;
+
+    // destructor
+    ~Sparse_Matrix() = default;
+
+    // show number of rows
+    size_t rows() const;
+
+    // show number of columns
+    size_t columns() const;
+
+    // show storage order, 'r' or 'c'
+    char storage_order() const;
+
+    // show number of stored elements
+    size_t non_zeros() const;
+
+    // constant element access operator, a binary search
+    T operator () (size_t, size_t) const;
+
+    // compressed arrays
+    const std::vector<size_t>& row_or_column_offsets() const;
+
+    const std::vector<size_t>& row_or_column_indices() const;
+
+    const std::vector<T>& nonzero_values() const;
+
+    // copy in the other storage order
+    Sparse_Matrix convert(char) const;
+
+    // transpose, which exchanges CSR and CSC without moving any values
+    Sparse_Matrix transpose() const;
+
+    // dense copy
+    Matrix<T> dense() const;
+
+    // * operator for dense matrices, also matrix-vector for one column
+    template<typename Alloc>
+    Matrix<T> operator * (const Matrix<T, Alloc>&) const;
+
+    // the same product split into tasks on a thread pool with
+    // load_range, such as Thread_Pool_G
+    template<typename Alloc, typename Pool>
+    Matrix<T> multiply(const Matrix<T, Alloc>&, Pool&, size_t = 0) const;
+
+};
+
+//*************************************************************************//
+
+//*************************************************************************//
+//
+// constructors, destructor, assignment operators and member functions
+//
+//*************************************************************************//
+
+// empty constructor
+template<typename T>
+Sparse_Matrix<T>::Sparse_Matrix(size_t r, size_t c, char o)
+
+    : n_rows(r)
+    , n_columns(c)
+    , order(o)
+    , offsets((o == 'r' ? r : c) + 1, 0) {
+
+    if(n_rows == 0 || n_columns == 0) {
+
+        throw std::out_of_range("matrix size of 0x0 not allowed");
+    }
+
+    if(order != 'r' && order != 'c') {
+
+        throw std::out_of_range("storage order must be 'r' or 'c'");
+    }
+}
+
+// dense constructor
+template<typename T>
+template<typename Alloc>
+Sparse_Matrix<T>::Sparse_Matrix(const Matrix<T, Alloc>& M, char o)
+
+    : Sparse_Matrix(M.rows(), M.columns(), o) {
+
+    size_t major_end = (order == 'r') ? n_rows : n_columns;
+    size_t minor_end = (order == 'r') ? n_columns : n_rows;
+
+    for(size_t a = 0; a < major_end; ++a) {
+
+        for(size_t b = 0; b < minor_end; ++b) {
+
+            T value = (order == 'r') ? M(a, b) : M(b, a);
+
+            if(value != T()) {
+
+                indices.push_back(b);
+                values.push_back(value);
+            }
+        }
+
+        offsets[a + 1] = values.size();
+    }
+}
+
+// compressed constructor
+template<typename T>
+Sparse_Matrix<T>::Sparse_Matrix(size_t r, size_t c, char o,
+                                std::vector<size_t> offsets_in,
+                                std::vector<size_t> indices_in,
+                                std::vector<T> values_in)
+
+    : Sparse_Matrix(r, c, o) {
+
+    size_t major_end = (order == 'r') ? n_rows : n_columns;
+    size_t minor_end = (order == 'r') ? n_columns : n_rows;
+
+    if(offsets_in.size() != major_end + 1 || offsets_in[0] != 0
+       || offsets_in.back() != values_in.size() || indices_in.size() != values_in.size()) {
+
+        throw std::out_of_range("dimension resolution error");
+    }
+
+    for(size_t a = 0; a < major_end; ++a) {
+
+        if(offsets_in[a] > offsets_in[a + 1]) {
+
+            throw std::out_of_range("dimension resolution error");
+        }
+
+        // indices within a row or column are strictly increasing
+        for(size_t e = offsets_in[a]; e < offsets_in[a + 1]; ++e) {
+
+            if(indices_in[e] >= minor_end || (e > offsets_in[a] && indices_in[e] <= indices_in[e - 1])) {
+
+                throw std::out_of_range("index out of bounds");
+            }
+        }
+    }
+
+    offsets = std::move(offsets_in);
+    indices = std::move(indices_in);
+    values = std::move(values_in);
+}
+
+// show number of rows
+template<typename T>
+size_t Sparse_Matrix<T>::rows() const { return n_rows; }
+
+// show number of columns
+template<typename T>
+size_t Sparse_Matrix<T>::columns() const { return n_columns; }
+
+// show storage order
+template<typename T>
+char Sparse_Matrix<T>::storage_order() const { return order; }
+
+// show number of stored elements
+template<typename T>
+size_t Sparse_Matrix<T>::non_zeros() const { return values.size(); }
+
+// constant element access operator
+template<typename T>
+T Sparse_Matrix<T>::operator () (size_t r, size_t c) const {
+
+    if(r >= n_rows || c >= n_columns) {
+
+        throw std::out_of_range("index out of bounds");
+    }
+
+    size_t major = (order == 'r') ? r : c;
+    size_t minor = (order == 'r') ? c : r;
+
+    std::vector<size_t>::const_iterator first = indices.begin() + offsets[major];
+    std::vector<size_t>::const_iterator last = indices.begin() + offsets[major + 1];
+    std::vector<size_t>::const_iterator found = std::lower_bound(first, last, minor);
+
+    if(found != last && *found == minor) { return values[found - indices.begin()]; }
+
+    return T();
+}
+
+// compressed arrays
+template<typename T>
+const std::vector<size_t>& Sparse_Matrix<T>::row_or_column_offsets() const { return offsets; }
+
+template<typename T>
+const std::vector<size_t>& Sparse_Matrix<T>::row_or_column_indices() const { return indices; }
+
+template<typename T>
+const std::vector<T>& Sparse_Matrix<T>::nonzero_values() const { return values; }
+
+// copy in the other storage order, a counting sort on the minor index
+template<typename T>
+Sparse_Matrix<T> Sparse_Matrix<T>::convert(char o) const {
+
+    if(o == order) { return *this; }
+
+    Sparse_Matrix<T> S(n_rows, n_columns, o);
+
+    size_t major_end = (order == 'r') ? n_rows : n_columns;
+
+    // count entries of each new row or column
+    for(size_t e = 0; e < indices.size(); ++e) { ++S.offsets[indices[e] + 1]; }
+
+    for(size_t a = 1; a < S.offsets.size(); ++a) { S.offsets[a] += S.offsets[a - 1]; }
+
+    S.indices.resize(values.size());
+    S.values.resize(values.size());
+
+    // walking the old order keeps the new indices sorted
+    std::vector<size_t> next(S.offsets.begin(), S.offsets.end() - 1);
+
+    for(size_t a = 0; a < major_end; ++a) {
+
+        for(size_t e = offsets[a]; e < offsets[a + 1]; ++e) {
+
+            size_t position = next[indices[e]]++;
+
+            S.indices[position] = a;
+            S.values[position] = values[e];
+        }
+    }
+
+    return S;
+}
+
+// transpose
+template<typename T>
+Sparse_Matrix<T> Sparse_Matrix<T>::transpose() const {
+
+    Sparse_Matrix<T> ST = *this;
+
+    std::swap(ST.n_rows, ST.n_columns);
+
+    ST.order = (order == 'r') ? 'c' : 'r';
+
+    return ST;
+}
+
+// dense copy
+template<typename T>
+Matrix<T> Sparse_Matrix<T>::dense() const {
+
+    Matrix<T> M(n_rows, n_columns);
+
+    size_t major_end = (order == 'r') ? n_rows : n_columns;
+
+    for(size_t a = 0; a < major_end; ++a) {
+
+        for(size_t e = offsets[a]; e < offsets[a + 1]; ++e) {
+
+            if(order == 'r') { M(a, indices[e]) = values[e]; }
+            else { M(indices[e], a) = values[e]; }
+        }
+    }
+
+    return M;
+}
+
+// rows [first, last) of a CSR product, each row of C is a sum of
+// scaled rows of B
+template<typename T>
+template<typename Alloc>
+void Sparse_Matrix<T>::row_product(size_t first, size_t last,
+                                   const Matrix<T, Alloc>& B, Matrix<T>& C) const {
+
+    size_t j_end = B.columns();
+
+    const T* b = B.data();
+    T* c = C.data();
+
+    for(size_t i = first; i < last; ++i) {
+
+        T* C_row = c + i * j_end;
+
+        std::fill(C_row, C_row + j_end, T());
+
+        for(size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+
+            T a = values[e];
+            const T* B_row = b + indices[e] * j_end;
+
+            for(size_t j = 0; j < j_end; ++j) { C_row[j] += a * B_row[j]; }
+        }
+    }
+}
+
+// columns [first, last) of B in a CSC product, column p of A is
+// scattered into C once for each row p of B
+template<typename T>
+template<typename Alloc>
+void Sparse_Matrix<T>::column_product(size_t first, size_t last,
+                                      const Matrix<T, Alloc>& B, Matrix<T>& C) const {
+
+    size_t j_end = B.columns();
+
+    const T* b = B.data();
+    T* c = C.data();
+
+    for(size_t i = 0; i < n_rows; ++i) {
+
+        std::fill(c + i * j_end + first, c + i * j_end + last, T());
+    }
+
+    for(size_t p = 0; p < n_columns; ++p) {
+
+        const T* B_row = b + p * j_end;
+
+        for(size_t e = offsets[p]; e < offsets[p + 1]; ++e) {
+
+            T a = values[e];
+            T* C_row = c + indices[e] * j_end;
+
+            for(size_t j = first; j < last; ++j) { C_row[j] += a * B_row[j]; }
+        }
+    }
+}
+
+// * operator for dense matrices
+template<typename T>
+template<typename Alloc>
+Matrix<T> Sparse_Matrix<T>::operator * (const Matrix<T, Alloc>& B) const {
+
+    if(n_columns != B.rows()) {
+
+        throw std::out_of_range("incorrect dimensions for a product");
+    }
+
+    Matrix<T> C(n_rows, B.columns(), uninitialized);
+
+    if(order == 'r') { Sparse_Matrix<T>::row_product(0, n_rows, B, C); }
+    else { Sparse_Matrix<T>::column_product(0, B.columns(), B, C); }
+
+    return C;
+}
+
+// the same product on a thread pool. CSR splits the rows of C into tasks
+// holding about equal numbers of nonzeros. CSC splits the columns of B
+// and C, so a CSC matrix-vector product stays on one task; convert to
+// CSR first for those. a tasks count of 0 uses 4 per hardware thread
+template<typename T>
+template<typename Alloc, typename Pool>
+Matrix<T> Sparse_Matrix<T>::multiply(const Matrix<T, Alloc>& B, Pool& TP, size_t tasks) const {
+
+    if(n_columns != B.rows()) {
+
+        throw std::out_of_range("incorrect dimensions for a product");
+    }
+
+    if(tasks == 0) { tasks = 4 * std::max(1u, std::thread::hardware_concurrency()); }
+
+    Matrix<T> C(n_rows, B.columns(), uninitialized);
+
+    if(order == 'r') {
+
+        size_t share = values.size() / tasks + 1;
+
+        // first row of every task and the end
+        std::vector<size_t> bounds(1, 0);
+
+        while(bounds.back() < n_rows) {
+
+            size_t first = bounds.back();
+
+            // end the task where its rows pass a share of the nonzeros
+            size_t last = std::upper_bound(offsets.begin() + first + 1, offsets.end() - 1,
+                                           offsets[first] + share) - offsets.begin();
+
+            bounds.push_back(std::max(last, first + 1));
+        }
+
+        TP.load_range(0, bounds.size() - 1, 1, [this, &bounds, &B, &C](size_t t, size_t) {
+
+            this->row_product(bounds[t], bounds[t + 1], B, C);
+
+        }).wait_all();
+
+    } else {
+
+        size_t j_end = B.columns();
+        size_t width = j_end / tasks + 1;
+
+        TP.load_range(0, j_end, width, [this, &B, &C](size_t first, size_t last) {
+
+            this->column_product(first, last, B, C);
+
+        }).wait_all();
+    }
+
+    return C;
+}
+
+//*************************************************************************//
+
+#endif // SPARSE_MATRIX_H_INCLUDED
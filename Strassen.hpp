@@ -3,26 +3,525 @@
 
 //*************************************************************************//
 
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <exception>
+
 #include "Matrix.hpp"
 #include "Thread_Pool_T.hpp"
+#include "Strassen_Profile.hpp"
+#include "Timer.hpp"
 
 //*************************************************************************//
 //
-// parallel and serial Strassen functors
+// allocation-free Strassen on views
+//
+// the quadrants of A, B and C are views of the caller's storage, and the
+// sums of quadrants and the products that feed more than one quadrant of
+// C go through three scratch blocks per level, X, Y and Z. deeper levels
+// take their scratch from the rest of the same workspace, so the peak
+// for an m x k by k x n product is
+//
+//     (mk + kn + mn) (1/4 + 1/16 + ... )  <  (mk + kn + mn) / 3
+//
+// elements, under n^2 for square products, allocated once up front. the
+// schedule below writes C = A * B, or C += A * B when accumulating:
+//
+//     X = A11 + A22, Y = B11 + B22, Z = X * Y     M1 -> C11, C22
+//     X = A21 + A22, C21 = X * B11                M2 -> C21, -C22
+//     Y = B12 - B22, C12 = A11 * Y                M3 -> C12, C22
+//     Y = B21 - B11, Z = A22 * Y                  M4 -> C11, C21
+//     X = A11 + A12, Z = X * B22                  M5 -> -C11, C12
+//     X = A21 - A11, Y = B11 + B12, Z = X * Y     M6 -> C22
+//     X = A12 - A22, Y = B21 + B22, C11 += X * Y  M7
+//
+// when accumulating, M2 and M3 go through Z as well. with the gemm
+// packing buffers also sized by the constructor, a product allocates
+// nothing on the thread that constructed the functor.
+//
+// odd dimensions are peeled at every level: the recursion runs on the
+// even core and a last row, column or inner index is added with thin
+// gemm products, so every size keeps the benefit of the recursion.
 //
 //*************************************************************************//
 
+// X = A + B
+template<typename T, typename U, typename V>
+void strassen_add(const Matrix_View<T>& X, const Matrix_View<U>& A,
+                  const Matrix_View<V>& B) {
+
+    for(size_t i = 0; i < X.rows(); ++i) {
+
+        T* x = &X(i, 0);
+
+        std::copy(&A(i, 0), &A(i, 0) + X.columns(), x);
+
+        simd_add(x, &B(i, 0), X.columns());
+    }
+}
+
+// X = A - B
+template<typename T, typename U, typename V>
+void strassen_subtract(const Matrix_View<T>& X, const Matrix_View<U>& A,
+                       const Matrix_View<V>& B) {
+
+    for(size_t i = 0; i < X.rows(); ++i) {
+
+        T* x = &X(i, 0);
+
+        std::copy(&A(i, 0), &A(i, 0) + X.columns(), x);
+
+        simd_subtract(x, &B(i, 0), X.columns());
+    }
+}
+
+// X = A
+template<typename T, typename U>
+void strassen_copy(const Matrix_View<T>& X, const Matrix_View<U>& A) {
+
+    for(size_t i = 0; i < X.rows(); ++i) {
+
+        std::copy(&A(i, 0), &A(i, 0) + X.columns(), &X(i, 0));
+    }
+}
+
+// X += A
+template<typename T, typename U>
+void strassen_add_to(const Matrix_View<T>& X, const Matrix_View<U>& A) {
+
+    for(size_t i = 0; i < X.rows(); ++i) { simd_add(&X(i, 0), &A(i, 0), X.columns()); }
+}
+
+// X -= A
+template<typename T, typename U>
+void strassen_subtract_from(const Matrix_View<T>& X, const Matrix_View<U>& A) {
+
+    for(size_t i = 0; i < X.rows(); ++i) { simd_subtract(&X(i, 0), &A(i, 0), X.columns()); }
+}
+
+// X = A - X
+template<typename T, typename U>
+void strassen_subtract_into(const Matrix_View<T>& X, const Matrix_View<U>& A) {
+
+    for(size_t i = 0; i < X.rows(); ++i) {
+
+        T* x = &X(i, 0);
+        const T* a = &A(i, 0);
+
+        for(size_t j = 0; j < X.columns(); ++j) { x[j] = a[j] - x[j]; }
+    }
+}
+
+// product of views through gemm
+template<typename U, typename V, typename T>
+void strassen_gemm(const Matrix_View<U>& A, const Matrix_View<V>& B,
+                   const Matrix_View<T>& C, bool accumulate) {
+
+    gemm(A.rows(), B.columns(), A.columns(),
+         A.data(), A.leading_dimension(),
+         B.data(), B.leading_dimension(),
+         C.data(), C.leading_dimension(), accumulate);
+}
+
+// dynamic peeling: once the even m2 x k2 by k2 x n2 core of C has been
+// formed, add the last column of A times the last row of B when k is
+// odd, and form the last column and last row of C when n or m is odd
+template<typename U, typename V, typename T>
+void strassen_peel(const Matrix_View<U>& A, const Matrix_View<V>& B,
+                   const Matrix_View<T>& C, bool accumulate) {
+
+    size_t m = A.rows(), k = A.columns(), n = B.columns();
+    size_t m2 = m & ~size_t(1), k2 = k & ~size_t(1), n2 = n & ~size_t(1);
+
+    if(k2 != k) {
+
+        strassen_gemm(A.slice(0, m2, k2, k), B.slice(k2, k, 0, n2), C.slice(0, m2, 0, n2), true);
+    }
+
+    if(n2 != n) {
+
+        strassen_gemm(A.slice(0, m2, 0, k), B.slice(0, k, n2, n), C.slice(0, m2, n2, n), accumulate);
+    }
+
+    if(m2 != m) {
+
+        strassen_gemm(A.slice(m2, m, 0, k), B, C.slice(m2, m, 0, n), accumulate);
+    }
+}
+
 template<typename T>
-struct Strassen {
+struct Workspace_Strassen {
+
+    // dimensions and recursion depth the workspace was sized for
+    size_t m, k, n, r;
+
+    // scratch for every level, allocated once
+    std::vector<T> workspace;
+
+    // scratch elements needed for an m x k by k x n product of depth r,
+    // odd dimensions are peeled to even ones before halving
+    static size_t workspace_size(size_t m, size_t k, size_t n, size_t r) {
+
+        size_t elements = 0;
+
+        for(; r > 0 && m > 1 && k > 1 && n > 1; --r) {
+
+            m /= 2;
+            k /= 2;
+            n /= 2;
+
+            elements += m * k + k * n + m * n;
+        }
+
+        return elements;
+    }
+
+    // constructors, also size the gemm packing buffers of this thread
+    Workspace_Strassen(size_t m_in, size_t k_in, size_t n_in, size_t r_in)
+
+        : m(m_in)
+        , k(k_in)
+        , n(n_in)
+        , r(r_in)
+        , workspace(workspace_size(m_in, k_in, n_in, r_in)) { gemm_reserve<T>(); }
+
+    Workspace_Strassen(size_t n_in, size_t r_in)
+
+        : Workspace_Strassen(n_in, n_in, n_in, r_in) {}
+
+    // show peak scratch memory in bytes
+    size_t peak_bytes() const { return workspace.size() * sizeof(T); }
+
+    // C = A * B, or C += A * B if accumulating, for m x k and k x n views
+    void operator () (const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+                      const Matrix_View<T>& C, bool accumulate = false) {
+
+        if(A.rows() != m || A.columns() != k ||
+           B.rows() != k || B.columns() != n ||
+           C.rows() != m || C.columns() != n) {
+
+            throw std::out_of_range("incorrect dimensions for a Strassen product");
+        }
+
+        Workspace_Strassen<T>::recurse(A, B, C, r, accumulate, workspace.data());
+    }
+
+    // C = A * B for matrices
+    template<typename Alloc>
+    void operator () (const Matrix<T, Alloc>& A, const Matrix<T, Alloc>& B, Matrix<T, Alloc>& C) {
+
+        (*this)(A.view(), B.view(), C.view());
+    }
+
+    static void recurse(const Matrix_View<const T>& A_in, const Matrix_View<const T>& B_in,
+                        const Matrix_View<T>& C_in, size_t r, bool accumulate, T* work) {
+
+        size_t m = A_in.rows(), k = A_in.columns(), n = B_in.columns();
+
+        // if depth is 0 or a dimension is too small to halve, perform a blocked gemm product
+        if(r == 0 || m < 2 || k < 2 || n < 2) {
+
+            strassen_gemm(A_in, B_in, C_in, accumulate);
+
+            return;
+        }
+
+        // quadrant sizes of the even core
+        size_t hm = m / 2, hk = k / 2, hn = n / 2;
+
+        Matrix_View<const T> A = A_in.slice(0, 2 * hm, 0, 2 * hk);
+        Matrix_View<const T> B = B_in.slice(0, 2 * hk, 0, 2 * hn);
+        Matrix_View<T> C = C_in.slice(0, 2 * hm, 0, 2 * hn);
+
+        // quadrants, viewed in place
+        Matrix_View<const T> A11 = A.slice(0, hm, 0, hk), A12 = A.slice(0, hm, hk, 2 * hk);
+        Matrix_View<const T> A21 = A.slice(hm, 2 * hm, 0, hk), A22 = A.slice(hm, 2 * hm, hk, 2 * hk);
+
+        Matrix_View<const T> B11 = B.slice(0, hk, 0, hn), B12 = B.slice(0, hk, hn, 2 * hn);
+        Matrix_View<const T> B21 = B.slice(hk, 2 * hk, 0, hn), B22 = B.slice(hk, 2 * hk, hn, 2 * hn);
+
+        Matrix_View<T> C11 = C.slice(0, hm, 0, hn), C12 = C.slice(0, hm, hn, 2 * hn);
+        Matrix_View<T> C21 = C.slice(hm, 2 * hm, 0, hn), C22 = C.slice(hm, 2 * hm, hn, 2 * hn);
+
+        // scratch of this level, the rest goes to deeper levels
+        Matrix_View<T> X(work, hm, hk, hk);
+        Matrix_View<T> Y(work + hm * hk, hk, hn, hn);
+        Matrix_View<T> Z(work + hm * hk + hk * hn, hm, hn, hn);
+
+        T* deeper = work + hm * hk + hk * hn + hm * hn;
+
+        r -= 1;
+
+        // M1 = (A11 + A22) * (B11 + B22)
+        strassen_add(X, A11, A22);
+        strassen_add(Y, B11, B22);
+        recurse(X, Y, Z, r, false, deeper);
+
+        if(accumulate) {
+
+            strassen_add_to(C11, Z);
+            strassen_add_to(C22, Z);
+
+        } else {
+
+            strassen_copy(C11, Z);
+            strassen_copy(C22, Z);
+        }
+
+        // M2 = (A21 + A22) * B11
+        strassen_add(X, A21, A22);
+
+        if(accumulate) {
+
+            recurse(X, B11, Z, r, false, deeper);
+            strassen_add_to(C21, Z);
+            strassen_subtract_from(C22, Z);
+
+        } else {
+
+            recurse(X, B11, C21, r, false, deeper);
+            strassen_subtract_from(C22, C21);
+        }
+
+        // M3 = A11 * (B12 - B22)
+        strassen_subtract(Y, B12, B22);
+
+        if(accumulate) {
+
+            recurse(A11, Y, Z, r, false, deeper);
+            strassen_add_to(C12, Z);
+            strassen_add_to(C22, Z);
+
+        } else {
+
+            recurse(A11, Y, C12, r, false, deeper);
+            strassen_add_to(C22, C12);
+        }
+
+        // M4 = A22 * (B21 - B11)
+        strassen_subtract(Y, B21, B11);
+        recurse(A22, Y, Z, r, false, deeper);
+        strassen_add_to(C11, Z);
+        strassen_add_to(C21, Z);
+
+        // M5 = (A11 + A12) * B22
+        strassen_add(X, A11, A12);
+        recurse(X, B22, Z, r, false, deeper);
+        strassen_subtract_from(C11, Z);
+        strassen_add_to(C12, Z);
+
+        // M6 = (A21 - A11) * (B11 + B12)
+        strassen_subtract(X, A21, A11);
+        strassen_add(Y, B11, B12);
+        recurse(X, Y, Z, r, false, deeper);
+        strassen_add_to(C22, Z);
+
+        // M7 = (A12 - A22) * (B21 + B22), added straight into C11
+        strassen_subtract(X, A12, A22);
+        strassen_add(Y, B21, B22);
+        recurse(X, Y, C11, r, true, deeper);
+
+        // odd rows, columns and inner dimension
+        strassen_peel(A_in, B_in, C_in, accumulate);
+    }
+
+};
+
+//*************************************************************************//
+//
+// Strassen-Winograd variant
+//
+// seven products and fifteen additions per level:
+//
+//     S1 = A21 + A22   T1 = B12 - B11   P1 = A11 * B11   P5 = S1 * T1
+//     S2 = S1 - A11    T2 = B22 - T1    P2 = A12 * B21   P6 = S2 * T2
+//     S3 = A11 - A21   T3 = B22 - B12   P3 = S4 * B22    P7 = S3 * T3
+//     S4 = A12 - S2    T4 = T2 - B21    P4 = A22 * T4
+//
+//     C11 = P1 + P2          U2 = P1 + P6     C12 = U2 + P5 + P3
+//     C21 = U2 + P7 - P4     C22 = U2 + P7 + P5
+//
+// the serial recursion follows the two-temporary schedule of Boyer,
+// Dumas, Pernet and Zhou, keeping the products in the quadrants of C:
+//
+//     X = S3, Y = T3, C21 = P7      X = S4, C11 = P3
+//     X = S1, Y = T1, C22 = P5      X = P1, combine U2 ... U7
+//     X = S2, Y = T2, C12 = P6      Y = T4, C11 = P4, C21 -= C11
+//                                   C11 = P2, C11 += X
+//
+// so a level needs only 2 * (n / 2)^2 scratch, less than 2 n^2 / 3 in
+// all. the combination of P1, P3, P5, P6 and P7 into C12, C21 and C22 is
+// fused row by row: every row of the five blocks is combined with SIMD
+// passes while it is still in L1, so the quadrants are streamed once.
+//
+//*************************************************************************//
+
+// with p1 in X and p3, p6, p7, p5 in C11, C12, C21, C22, form
+// C12 = p1 + p6 + p5 + p3, C21 = p1 + p6 + p7 and C22 = p1 + p6 + p7 + p5
+template<typename T, typename U>
+void winograd_combine(const Matrix_View<U>& X,
+                      const Matrix_View<T>& C11, const Matrix_View<T>& C12,
+                      const Matrix_View<T>& C21, const Matrix_View<T>& C22) {
+
+    size_t j_end = X.columns();
+
+    for(size_t i = 0; i < X.rows(); ++i) {
+
+        T* c11 = &C11(i, 0);
+        T* c12 = &C12(i, 0);
+        T* c21 = &C21(i, 0);
+        T* c22 = &C22(i, 0);
+
+        simd_add(c12, &X(i, 0), j_end);     // U2 = P1 + P6
+        simd_add(c21, c12, j_end);          // U3 = U2 + P7
+        simd_add(c12, c22, j_end);          // U4 = U2 + P5
+        simd_add(c22, c21, j_end);          // U7 = U3 + P5
+        simd_add(c12, c11, j_end);          // U5 = U4 + P3
+    }
+}
+
+template<typename T>
+struct Workspace_Winograd {
+
+    // dimension and recursion depth the workspace was sized for
+    size_t n, r;
+
+    // scratch for every level, allocated once
+    std::vector<T> workspace;
+
+    // scratch elements needed for an n x n product of depth r
+    static size_t workspace_size(size_t n, size_t r) {
+
+        size_t elements = 0;
+
+        for(; r > 0 && n % 2 == 0; --r) {
+
+            n /= 2;
+            elements += 2 * n * n;
+        }
+
+        return elements;
+    }
+
+    // constructor, also sizes the gemm packing buffers of this thread
+    Workspace_Winograd(size_t n_in, size_t r_in)
+
+        : n(n_in)
+        , r(r_in)
+        , workspace(workspace_size(n_in, r_in)) { gemm_reserve<T>(); }
+
+    // show peak scratch memory in bytes
+    size_t peak_bytes() const { return workspace.size() * sizeof(T); }
+
+    // C = A * B for n x n views
+    void operator () (const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+                      const Matrix_View<T>& C) {
+
+        if(A.rows() != n || A.columns() != n ||
+           B.rows() != n || B.columns() != n ||
+           C.rows() != n || C.columns() != n) {
+
+            throw std::out_of_range("incorrect dimensions for a Strassen product");
+        }
+
+        Workspace_Winograd<T>::recurse(A, B, C, r, workspace.data());
+    }
+
+    // C = A * B for n x n matrices
+    template<typename Alloc>
+    void operator () (const Matrix<T, Alloc>& A, const Matrix<T, Alloc>& B, Matrix<T, Alloc>& C) {
+
+        (*this)(A.view(), B.view(), C.view());
+    }
+
+    static void recurse(const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+                        const Matrix_View<T>& C, size_t r, T* work) {
+
+        size_t m = A.rows();
+
+        // if depth is 0 or dimension is odd, perform a blocked gemm product
+        if(r == 0 || m % 2 != 0) {
+
+            gemm(m, m, m, A.data(), A.leading_dimension(),
+                 B.data(), B.leading_dimension(),
+                 C.data(), C.leading_dimension(), false);
+
+            return;
+        }
+
+        size_t h = m / 2;
+
+        // quadrants, viewed in place
+        Matrix_View<const T> A11 = A.slice(0, h, 0, h), A12 = A.slice(0, h, h, m);
+        Matrix_View<const T> A21 = A.slice(h, m, 0, h), A22 = A.slice(h, m, h, m);
+
+        Matrix_View<const T> B11 = B.slice(0, h, 0, h), B12 = B.slice(0, h, h, m);
+        Matrix_View<const T> B21 = B.slice(h, m, 0, h), B22 = B.slice(h, m, h, m);
+
+        Matrix_View<T> C11 = C.slice(0, h, 0, h), C12 = C.slice(0, h, h, m);
+        Matrix_View<T> C21 = C.slice(h, m, 0, h), C22 = C.slice(h, m, h, m);
+
+        // scratch of this level, the rest goes to deeper levels
+        Matrix_View<T> X(work, h, h, h);
+        Matrix_View<T> Y(work + h * h, h, h, h);
+
+        T* deeper = work + 2 * h * h;
+
+        r -= 1;
+
+        // P7 = S3 * T3
+        strassen_subtract(X, A11, A21);
+        strassen_subtract(Y, B22, B12);
+        recurse(X, Y, C21, r, deeper);
+
+        // P5 = S1 * T1
+        strassen_add(X, A21, A22);
+        strassen_subtract(Y, B12, B11);
+        recurse(X, Y, C22, r, deeper);
+
+        // P6 = S2 * T2, S2 = S1 - A11 and T2 = B22 - T1 in place
+        strassen_subtract_from(X, A11);
+        strassen_subtract_into(Y, B22);
+        recurse(X, Y, C12, r, deeper);
+
+        // P3 = S4 * B22, S4 = A12 - S2 in place
+        strassen_subtract_into(X, A12);
+        recurse(X, B22, C11, r, deeper);
+
+        // P1 = A11 * B11, then U2 ... U7 in one fused pass
+        recurse(A11, B11, X, r, deeper);
+        winograd_combine(X, C11, C12, C21, C22);
+
+        // P4 = A22 * T4, T4 = T2 - B21 in place, C21 = U3 - P4
+        strassen_subtract_from(Y, B21);
+        recurse(A22, Y, C11, r, deeper);
+        strassen_subtract_from(C21, C11);
+
+        // P2 = A12 * B21, C11 = P1 + P2
+        recurse(A12, B21, C11, r, deeper);
+        strassen_add_to(C11, X);
+    }
+
+};
+
+// serial Winograd functor, used like Strassen
+template<typename T>
+struct Winograd {
 
     // intermal matrices
     Matrix<T> A, B;
 
-    // depths for recursion and for using thread pool for parallelism
-    size_t r, p;
+    // depth for recursion
+    size_t r;
 
     // constructor
-    Strassen(Matrix<T> A_in, Matrix<T> B_in,
+    Winograd(Matrix<T> A_in, Matrix<T> B_in,
              size_t r_in)
 
         : A(std::move(A_in))
@@ -37,72 +536,61 @@ struct Strassen {
         }
     }
 
-    // operator
+    // operator, recursion works in place with one workspace
     Matrix<T> operator () () {
 
-        // if depth is 1 or dimension is odd, perform ikj multiplication
-        if(r == 0 || A.rows() % 2 != 0) { return A * B; }
+        Matrix<T> C(A.rows(), B.columns(), uninitialized);
 
-        // specify ranges for A and B submatrices
-        size_t n = A.rows() / 2;
-        
-        // A submatrices
-        Matrix<T> A11 = std::move(A.slice(0, n, 0, n));
-        Matrix<T> A12 = std::move(A.slice(0, n, n, 2 * n));
-        Matrix<T> A21 = std::move(A.slice(n, 2 * n, 0, n));
-        Matrix<T> A22 = std::move(A.slice(n, 2 * n, n, 2 * n));
-        
-        // B submatrices
-        Matrix<T> B11 = std::move(B.slice(0, n, 0, n));
-        Matrix<T> B12 = std::move(B.slice(0, n, n, 2 * n));
-        Matrix<T> B21 = std::move(B.slice(n, 2 * n, 0, n));
-        Matrix<T> B22 = std::move(B.slice(n, 2 * n, n, 2 * n));
-        
-        // decrement depth for recursion
-        r -= 1;
+        Workspace_Winograd<T>(A.rows(), r)(A, B, C);
 
-        // M1 = (A11 + A22) * (B11 + B22)
-        Matrix<T> M1 = std::move(Strassen<T>(A11 + A22, B11 + B22, r)());
-        
-        // M2 = (A21 + A22) * B11
-        Matrix<T> M2 = std::move(Strassen<T>(A21 + A22, B11, r)());
-        
-        // M3 = A11 * (B12 - B22)
-        Matrix<T> M3 = std::move(Strassen<T>(A11, B12 - B22, r)());
-        
-        // M4 = A22 * (B21 - B11)
-        Matrix<T> M4 = std::move(Strassen<T>(A22, B21 - B11, r)());
-        
-        // M5 = (A11 + A12) * B22
-        Matrix<T> M5 = std::move(Strassen<T>(A11 + A12, B22, r)());
-        
-        // M6 = (A21 - A11) * (B11 + B12)
-        Matrix<T> M6 = std::move(Strassen<T>(A21 - A11, B11 + B12, r)());
-        
-        // M7 = (A12 - A22) * (B21 + B22)
-        Matrix<T> M7 = std::move(Strassen<T>(A12 - A22, B21 + B22, r)());
+        return C;
+    }
 
-        // specify return matrix C
-        Matrix<T> C(A.rows(), B.columns());
+};
 
-        // put elements into C
-        for(size_t i = 0; i < n; ++i) {
+//*************************************************************************//
+//
+// parallel and serial Strassen functors
+//
+//*************************************************************************//
 
-            for(size_t j = 0; j < n; ++j) {
-                
-                // C11 = M1 + M4 - M5 + M7
-                C(i, j) = M1(i, j) + M4(i, j) - M5(i, j) + M7(i, j);
-                
-                // C12 = M3 + M5
-                C(i, n + j) = M3(i, j) + M5(i, j);
-                
-                // C21 = M2 + M4
-                C(n + i, j) = M2(i, j) + M4(i, j);
-                
-                // C22 = M1 - M2 + M3 + M6
-                C(n + i, n + j) = M1(i, j) - M2(i, j) + M3(i, j) + M6(i, j);
-            }
+template<typename T>
+struct Strassen {
+
+    // intermal matrices
+    Matrix<T> A, B;
+
+    // depths for recursion and for using thread pool for parallelism
+    size_t r, p;
+
+    // constructor, any m x k by k x n product
+    Strassen(Matrix<T> A_in, Matrix<T> B_in,
+             size_t r_in)
+
+        : A(std::move(A_in))
+        , B(std::move(B_in))
+        , r(r_in) {
+
+        if(A.columns() != B.rows()) {
+
+            throw std::out_of_range("incorrect dimensions for a Strassen product");
         }
+    }
+
+    // constructor, depth chosen from the machine profile
+    Strassen(Matrix<T> A_in, Matrix<T> B_in)
+
+        : Strassen(std::move(A_in), std::move(B_in), 0) {
+
+        r = strassen_profile().depth(A.rows(), A.columns(), B.columns());
+    }
+
+    // operator, recursion works in place with one workspace
+    Matrix<T> operator () () {
+
+        Matrix<T> C(A.rows(), B.columns(), uninitialized);
+
+        Workspace_Strassen<T>(A.rows(), A.columns(), B.columns(), r)(A, B, C);
 
         return C;
     }
@@ -123,7 +611,7 @@ struct Parallel_Strassen {
     // thread pool reference
     Thread_Pool<Matrix<T>>& TP;
 
-    // constructor
+    // constructor, any m x k by k x n product
     Parallel_Strassen(Matrix<T> A_in, Matrix<T> B_in,
                       size_t r_in, size_t p_in,
                       Thread_Pool<Matrix<T>>& TP_in)
@@ -134,35 +622,45 @@ struct Parallel_Strassen {
         , p(p_in)
         , TP(TP_in) {
 
-        if(A.rows() != B.rows() ||
-           A.rows() != B.columns() ||
-           A.columns() != B.columns()) {
+        if(A.columns() != B.rows()) {
 
             throw std::out_of_range("incorrect dimensions for a Strassen product");
         }
     }
 
-    // operator
-    Matrix<T> operator () () {
+    // constructor, both depths chosen from the machine profile
+    Parallel_Strassen(Matrix<T> A_in, Matrix<T> B_in,
+                      Thread_Pool<Matrix<T>>& TP_in)
+
+        : Parallel_Strassen(std::move(A_in), std::move(B_in), 0, 0, TP_in) {
+
+        r = strassen_profile().depth(A.rows(), A.columns(), B.columns());
+        p = strassen_profile().parallel(r, TP.size());
+    }
+
+    // operator
+    Matrix<T> operator () () {
+
+        // if depth is 0 or a dimension is too small to halve, perform a blocked gemm product
+        if(r == 0 || A.rows() < 2 || A.columns() < 2 || B.columns() < 2) { return A * B; }
+
+        // quadrant sizes of the even core, odd edges are peeled below
+        size_t hm = A.rows() / 2;
+        size_t hk = A.columns() / 2;
+        size_t hn = B.columns() / 2;
+
+        // A submatrices, viewed in place
+        Matrix_View<T> A11 = A.slice(0, hm, 0, hk);
+        Matrix_View<T> A12 = A.slice(0, hm, hk, 2 * hk);
+        Matrix_View<T> A21 = A.slice(hm, 2 * hm, 0, hk);
+        Matrix_View<T> A22 = A.slice(hm, 2 * hm, hk, 2 * hk);
+
+        // B submatrices, viewed in place
+        Matrix_View<T> B11 = B.slice(0, hk, 0, hn);
+        Matrix_View<T> B12 = B.slice(0, hk, hn, 2 * hn);
+        Matrix_View<T> B21 = B.slice(hk, 2 * hk, 0, hn);
+        Matrix_View<T> B22 = B.slice(hk, 2 * hk, hn, 2 * hn);
 
-        // if depth is 1 or dimension is odd, perform ikj multiplication
-        if(r == 0 || A.rows() % 2 != 0) { return A * B; }
-            
-        // specify ranges for A and B submatrices
-        size_t n = A.rows() / 2;
-        
-        // A submatrices
-        Matrix<T> A11 = std::move(A.slice(0, n, 0, n));
-        Matrix<T> A12 = std::move(A.slice(0, n, n, 2 * n));
-        Matrix<T> A21 = std::move(A.slice(n, 2 * n, 0, n));
-        Matrix<T> A22 = std::move(A.slice(n, 2 * n, n, 2 * n));
-        
-        // B submatrices
-        Matrix<T> B11 = std::move(B.slice(0, n, 0, n));
-        Matrix<T> B12 = std::move(B.slice(0, n, n, 2 * n));
-        Matrix<T> B21 = std::move(B.slice(n, 2 * n, 0, n));
-        Matrix<T> B22 = std::move(B.slice(n, 2 * n, n, 2 * n));
-        
         // decrement depth for recursion
         r -= 1;
 
@@ -172,39 +670,39 @@ struct Parallel_Strassen {
         if(p == 0) {
 
             // M1 = (A11 + A22) * (B11 + B22)
-            std::future<Matrix<T>> f_M1 =
+            Pool_Future<Matrix<T>> f_M1 =
 
-                TP.load_front(std::move(Strassen<T>(A11 + A22, B11 + B22, r)));
+                TP.submit(std::move(Strassen<T>(A11 + A22, B11 + B22, r)));
             
             // M2 = (A21 + A22) * B11
-            std::future<Matrix<T>> f_M2 =
+            Pool_Future<Matrix<T>> f_M2 =
 
-                TP.load_front(std::move(Strassen<T>(A21 + A22, B11, r)));
+                TP.submit(std::move(Strassen<T>(A21 + A22, B11, r)));
             
             // M3 = A11 * (B12 - B22)
-            std::future<Matrix<T>> f_M3 =
+            Pool_Future<Matrix<T>> f_M3 =
 
-                TP.load_front(std::move(Strassen<T>(A11, B12 - B22, r)));
+                TP.submit(std::move(Strassen<T>(A11, B12 - B22, r)));
             
             // M4 = A22 * (B21 - B11)
-            std::future<Matrix<T>> f_M4 =
+            Pool_Future<Matrix<T>> f_M4 =
 
-                TP.load_front(std::move(Strassen<T>(A22, B21 - B11, r)));
+                TP.submit(std::move(Strassen<T>(A22, B21 - B11, r)));
             
             // M5 = (A11 + A12) * B22
-            std::future<Matrix<T>> f_M5 =
+            Pool_Future<Matrix<T>> f_M5 =
 
-                TP.load_front(std::move(Strassen<T>(A11 + A12, B22, r)));
+                TP.submit(std::move(Strassen<T>(A11 + A12, B22, r)));
             
             // M6 = (A21 - A11) * (B11 + B12)
-            std::future<Matrix<T>> f_M6 =
+            Pool_Future<Matrix<T>> f_M6 =
 
-                TP.load_front(std::move(Strassen<T>(A21 - A11, B11 + B12, r)));
+                TP.submit(std::move(Strassen<T>(A21 - A11, B11 + B12, r)));
             
             // M7 = (A12 - A22) * (B21 + B22)
-            std::future<Matrix<T>> f_M7 =
+            Pool_Future<Matrix<T>> f_M7 =
 
-                TP.load_front(std::move(Strassen<T>(A12 - A22, B21 + B22, r)));
+                TP.submit(std::move(Strassen<T>(A12 - A22, B21 + B22, r)));
 
             M1 = std::move(f_M1.get());
             M2 = std::move(f_M2.get());
@@ -241,28 +739,31 @@ struct Parallel_Strassen {
             M7 = std::move(Parallel_Strassen<T>(A12 - A22, B21 + B22, r, p, TP)());
         }
 
-        // specify return matrix C
-        Matrix<T> C(A.rows(), B.columns());
+        // specify return matrix C, every element is written below
+        Matrix<T> C(A.rows(), B.columns(), uninitialized);
 
         // put elements into C
-        for(size_t i = 0; i < n; ++i) {
+        for(size_t i = 0; i < hm; ++i) {
+
+            for(size_t j = 0; j < hn; ++j) {
 
-            for(size_t j = 0; j < n; ++j) {
-                
                 // C11 = M1 + M4 - M5 + M7
                 C(i, j) = M1(i, j) + M4(i, j) - M5(i, j) + M7(i, j);
-                
+
                 // C12 = M3 + M5
-                C(i, n + j) = M3(i, j) + M5(i, j);
-                
+                C(i, hn + j) = M3(i, j) + M5(i, j);
+
                 // C21 = M2 + M4
-                C(n + i, j) = M2(i, j) + M4(i, j);
-                
+                C(hm + i, j) = M2(i, j) + M4(i, j);
+
                 // C22 = M1 - M2 + M3 + M6
-                C(n + i, n + j) = M1(i, j) - M2(i, j) + M3(i, j) + M6(i, j);
+                C(hm + i, hn + j) = M1(i, j) - M2(i, j) + M3(i, j) + M6(i, j);
             }
         }
 
+        // odd rows, columns and inner dimension
+        strassen_peel(A.view(), B.view(), C.view(), false);
+
         return C;
     }
 
@@ -270,4 +771,810 @@ struct Parallel_Strassen {
 
 //*************************************************************************//
 
+template<typename T>
+struct Parallel_Winograd {
+
+    // intermal matrices
+    Matrix<T> A, B;
+
+    // depths for recursion and for using thread pool for parallelism
+    size_t r, p;
+
+    // thread pool reference
+    Thread_Pool<Matrix<T>>& TP;
+
+    // constructor
+    Parallel_Winograd(Matrix<T> A_in, Matrix<T> B_in,
+                      size_t r_in, size_t p_in,
+                      Thread_Pool<Matrix<T>>& TP_in)
+
+        : A(std::move(A_in))
+        , B(std::move(B_in))
+        , r(r_in)
+        , p(p_in)
+        , TP(TP_in) {
+
+        if(A.rows() != B.rows() ||
+           A.rows() != B.columns() ||
+           A.columns() != B.columns()) {
+
+            throw std::out_of_range("incorrect dimensions for a Strassen product");
+        }
+    }
+
+    // operator
+    Matrix<T> operator () () {
+
+        // if depth is 0 or dimension is odd, perform a blocked gemm product
+        if(r == 0 || A.rows() % 2 != 0) { return A * B; }
+
+        // specify ranges for A and B submatrices
+        size_t n = A.rows() / 2;
+
+        // A submatrices, viewed in place
+        Matrix_View<T> A11 = A.slice(0, n, 0, n);
+        Matrix_View<T> A12 = A.slice(0, n, n, 2 * n);
+        Matrix_View<T> A21 = A.slice(n, 2 * n, 0, n);
+        Matrix_View<T> A22 = A.slice(n, 2 * n, n, 2 * n);
+
+        // B submatrices, viewed in place
+        Matrix_View<T> B11 = B.slice(0, n, 0, n);
+        Matrix_View<T> B12 = B.slice(0, n, n, 2 * n);
+        Matrix_View<T> B21 = B.slice(n, 2 * n, 0, n);
+        Matrix_View<T> B22 = B.slice(n, 2 * n, n, 2 * n);
+
+        // decrement depth for recursion
+        r -= 1;
+
+        // sums of quadrants, each formed once
+        Matrix<T> S1 = A21 + A22;
+        Matrix<T> S2 = S1 - A11;
+        Matrix<T> S3 = A11 - A21;
+        Matrix<T> S4 = A12 - S2;
+
+        Matrix<T> T1 = B12 - B11;
+        Matrix<T> T2 = B22 - T1;
+        Matrix<T> T3 = B22 - B12;
+        Matrix<T> T4 = T2 - B21;
+
+        // declare intermediate matrices
+        Matrix<T> P1, P2, P3, P4, P5, P6, P7;
+
+        if(p == 0) {
+
+            Pool_Future<Matrix<T>> f_P1 = TP.submit(Winograd<T>(A11, B11, r));
+            Pool_Future<Matrix<T>> f_P2 = TP.submit(Winograd<T>(A12, B21, r));
+            Pool_Future<Matrix<T>> f_P3 = TP.submit(Winograd<T>(std::move(S4), B22, r));
+            Pool_Future<Matrix<T>> f_P4 = TP.submit(Winograd<T>(A22, std::move(T4), r));
+            Pool_Future<Matrix<T>> f_P5 = TP.submit(Winograd<T>(std::move(S1), std::move(T1), r));
+            Pool_Future<Matrix<T>> f_P6 = TP.submit(Winograd<T>(std::move(S2), std::move(T2), r));
+            Pool_Future<Matrix<T>> f_P7 = TP.submit(Winograd<T>(std::move(S3), std::move(T3), r));
+
+            P1 = f_P1.get();
+            P2 = f_P2.get();
+            P3 = f_P3.get();
+            P4 = f_P4.get();
+            P5 = f_P5.get();
+            P6 = f_P6.get();
+            P7 = f_P7.get();
+
+        } else {
+
+            // ensure that parallelism is used at a certain depth and not further
+            p -= 1;
+
+            P1 = Parallel_Winograd<T>(A11, B11, r, p, TP)();
+            P2 = Parallel_Winograd<T>(A12, B21, r, p, TP)();
+            P3 = Parallel_Winograd<T>(std::move(S4), B22, r, p, TP)();
+            P4 = Parallel_Winograd<T>(A22, std::move(T4), r, p, TP)();
+            P5 = Parallel_Winograd<T>(std::move(S1), std::move(T1), r, p, TP)();
+            P6 = Parallel_Winograd<T>(std::move(S2), std::move(T2), r, p, TP)();
+            P7 = Parallel_Winograd<T>(std::move(S3), std::move(T3), r, p, TP)();
+        }
+
+        // specify return matrix C, every element is written below
+        Matrix<T> C(A.rows(), B.columns(), uninitialized);
+
+        Matrix_View<T> C11 = C.slice(0, n, 0, n);
+        Matrix_View<T> C12 = C.slice(0, n, n, 2 * n);
+        Matrix_View<T> C21 = C.slice(n, 2 * n, 0, n);
+        Matrix_View<T> C22 = C.slice(n, 2 * n, n, 2 * n);
+
+        // move the products into place, then combine them in fused passes
+        strassen_copy(C11, P3.view());
+        strassen_copy(C12, P6.view());
+        strassen_copy(C21, P7.view());
+        strassen_copy(C22, P5.view());
+
+        winograd_combine(P1.view(), C11, C12, C21, C22);
+
+        strassen_subtract_from(C21, P4.view());
+        strassen_add(C11, P1.view(), P2.view());
+
+        return C;
+    }
+
+};
+
+//*************************************************************************//
+//
+// task graph Strassen
+//
+// every level down to depth p is expanded by a pool task that forms the
+// seven operand pairs, hands one task per product to the pool and
+// returns. a node counts its outstanding products, and whichever task
+// finishes the last one combines them into the node's product and
+// reports to the parent in turn. no worker ever waits on another task,
+// and all 7^p products are in the pool at once. the leaves finish the
+// remaining r - p levels serially with a workspace Strassen.
+//
+// the calling thread runs pool tasks until the root completes, so the
+// graph can also be started from inside a pool task. p counts spawned
+// levels, so depth p spawns as many products as Parallel_Strassen with
+// depth p - 1. a functor computes its product once.
+//
+//*************************************************************************//
+
+template<typename T>
+struct Graph_Strassen {
+
+    // intermal matrices
+    Matrix<T> A, B;
+
+    // depths for recursion and for spawned levels
+    size_t r, p;
+
+    // thread pool reference
+    Thread_Pool<Matrix<T>>& TP;
+
+    // constructor, any m x k by k x n product
+    Graph_Strassen(Matrix<T> A_in, Matrix<T> B_in,
+                   size_t r_in, size_t p_in,
+                   Thread_Pool<Matrix<T>>& TP_in)
+
+        : A(std::move(A_in))
+        , B(std::move(B_in))
+        , r(r_in)
+        , p(p_in)
+        , TP(TP_in)
+        , failed(false) {
+
+        if(A.columns() != B.rows()) {
+
+            throw std::out_of_range("incorrect dimensions for a Strassen product");
+        }
+    }
+
+    // constructor, both depths chosen from the machine profile
+    Graph_Strassen(Matrix<T> A_in, Matrix<T> B_in,
+                   Thread_Pool<Matrix<T>>& TP_in)
+
+        : Graph_Strassen(std::move(A_in), std::move(B_in), 0, 0, TP_in) {
+
+        r = strassen_profile().depth(A.rows(), A.columns(), B.columns());
+        p = r == 0 ? 0 : strassen_profile().parallel(r, TP.size()) + 1;
+    }
+
+    // operator
+    Matrix<T> operator () () {
+
+        Matrix<T> C(A.rows(), B.columns(), uninitialized);
+
+        Pool_Future<void> done = TP.wrap(finished.get_future());
+
+        // the root is expanded on the calling thread
+        run(new Node(std::move(A), std::move(B), C.view(), r, p, 0));
+
+        done.wait();
+
+        if(failed) { std::rethrow_exception(error); }
+
+        return C;
+    }
+
+private:
+
+    // one product of the graph
+    struct Node {
+
+        // operands, kept for the peeling of odd edges
+        Matrix<T> A, B;
+
+        // where the product goes
+        Matrix_View<T> C;
+
+        // remaining depths
+        size_t r, p;
+
+        // node waiting for this product, 0 for the root
+        Node* parent;
+
+        // products of the seven children
+        Matrix<T> M[7];
+
+        // children and expansion still running
+        std::atomic<size_t> pending;
+
+        Node(Matrix<T> A_in, Matrix<T> B_in, Matrix_View<T> C_in,
+             size_t r_in, size_t p_in, Node* parent_in)
+
+            : A(std::move(A_in))
+            , B(std::move(B_in))
+            , C(C_in)
+            , r(r_in)
+            , p(p_in)
+            , parent(parent_in)
+            , pending(0) {}
+    };
+
+    // completion of the root
+    std::promise<void> finished;
+
+    // first exception thrown by a task, the graph still runs to completion
+    std::atomic_bool failed;
+
+    std::exception_ptr error;
+
+    std::mutex error_muter;
+
+    void fail() {
+
+        std::lock_guard<std::mutex> lock(error_muter);
+
+        if(!failed) { error = std::current_exception(); failed = true; }
+    }
+
+    // compute a leaf or expand a node into seven tasks
+    void run(Node* node) {
+
+        size_t m = node->A.rows();
+        size_t k = node->A.columns();
+        size_t n = node->B.columns();
+
+        if(node->p == 0 || node->r == 0 || m < 2 || k < 2 || n < 2) {
+
+            try {
+
+                Workspace_Strassen<T>(m, k, n, node->r)(node->A.view(), node->B.view(), node->C);
+
+            } catch(...) { fail(); }
+
+            finish(node);
+
+            return;
+        }
+
+        // quadrant sizes of the even core, odd edges are peeled on combination
+        size_t hm = m / 2;
+        size_t hk = k / 2;
+        size_t hn = n / 2;
+
+        Matrix_View<T> A11 = node->A.slice(0, hm, 0, hk);
+        Matrix_View<T> A12 = node->A.slice(0, hm, hk, 2 * hk);
+        Matrix_View<T> A21 = node->A.slice(hm, 2 * hm, 0, hk);
+        Matrix_View<T> A22 = node->A.slice(hm, 2 * hm, hk, 2 * hk);
+
+        Matrix_View<T> B11 = node->B.slice(0, hk, 0, hn);
+        Matrix_View<T> B12 = node->B.slice(0, hk, hn, 2 * hn);
+        Matrix_View<T> B21 = node->B.slice(hk, 2 * hk, 0, hn);
+        Matrix_View<T> B22 = node->B.slice(hk, 2 * hk, hn, 2 * hn);
+
+        size_t r_c = node->r - 1;
+        size_t p_c = node->p - 1;
+
+        // seven products and the expansion itself
+        node->pending = 8;
+
+        size_t spawned = 0;
+
+        try {
+
+            for(size_t i = 0; i < 7; ++i) { node->M[i] = Matrix<T>(hm, hn, uninitialized); }
+
+            // M1 = (A11 + A22) * (B11 + B22)
+            spawn(new Node(A11 + A22, B11 + B22, node->M[0].view(), r_c, p_c, node));
+            ++spawned;
+
+            // M2 = (A21 + A22) * B11
+            spawn(new Node(A21 + A22, B11, node->M[1].view(), r_c, p_c, node));
+            ++spawned;
+
+            // M3 = A11 * (B12 - B22)
+            spawn(new Node(A11, B12 - B22, node->M[2].view(), r_c, p_c, node));
+            ++spawned;
+
+            // M4 = A22 * (B21 - B11)
+            spawn(new Node(A22, B21 - B11, node->M[3].view(), r_c, p_c, node));
+            ++spawned;
+
+            // M5 = (A11 + A12) * B22
+            spawn(new Node(A11 + A12, B22, node->M[4].view(), r_c, p_c, node));
+            ++spawned;
+
+            // M6 = (A21 - A11) * (B11 + B12)
+            spawn(new Node(A21 - A11, B11 + B12, node->M[5].view(), r_c, p_c, node));
+            ++spawned;
+
+            // M7 = (A12 - A22) * (B21 + B22)
+            spawn(new Node(A12 - A22, B21 + B22, node->M[6].view(), r_c, p_c, node));
+            ++spawned;
+
+        } catch(...) { fail(); }
+
+        // release the expansion and any product that was never spawned
+        release(node, 8 - spawned);
+    }
+
+    // hand a node to the pool
+    void spawn(Node* node) {
+
+        try {
+
+            TP.post_front([this, node] { run(node); });
+
+        } catch(...) {
+
+            delete node;
+
+            throw;
+        }
+    }
+
+    // count finished pieces of a node, the last one combines
+    void release(Node* node, size_t count) {
+
+        if(node->pending.fetch_sub(count) != count) { return; }
+
+        if(!failed) {
+
+            try { combine(node); } catch(...) { fail(); }
+        }
+
+        finish(node);
+    }
+
+    // report a finished node to its parent
+    void finish(Node* node) {
+
+        Node* parent = node->parent;
+
+        delete node;
+
+        if(parent) { release(parent, 1); } else { finished.set_value(); }
+    }
+
+    // form the product of a node from the products of its children
+    void combine(Node* node) {
+
+        size_t hm = node->M[0].rows();
+        size_t hn = node->M[0].columns();
+
+        Matrix_View<T> C11 = node->C.slice(0, hm, 0, hn);
+        Matrix_View<T> C12 = node->C.slice(0, hm, hn, 2 * hn);
+        Matrix_View<T> C21 = node->C.slice(hm, 2 * hm, 0, hn);
+        Matrix_View<T> C22 = node->C.slice(hm, 2 * hm, hn, 2 * hn);
+
+        Matrix_View<T> M1 = node->M[0].view();
+        Matrix_View<T> M2 = node->M[1].view();
+        Matrix_View<T> M3 = node->M[2].view();
+        Matrix_View<T> M4 = node->M[3].view();
+        Matrix_View<T> M5 = node->M[4].view();
+        Matrix_View<T> M6 = node->M[5].view();
+        Matrix_View<T> M7 = node->M[6].view();
+
+        // C11 = M1 + M4 - M5 + M7
+        strassen_add(C11, M1, M4);
+        strassen_subtract_from(C11, M5);
+        strassen_add_to(C11, M7);
+
+        // C12 = M3 + M5
+        strassen_add(C12, M3, M5);
+
+        // C21 = M2 + M4
+        strassen_add(C21, M2, M4);
+
+        // C22 = M1 - M2 + M3 + M6
+        strassen_subtract(C22, M1, M2);
+        strassen_add_to(C22, M3);
+        strassen_add_to(C22, M6);
+
+        // odd rows, columns and inner dimension
+        strassen_peel(node->A.view(), node->B.view(), node->C, false);
+    }
+
+};
+
+//*************************************************************************//
+//
+// memory-capped Strassen
+//
+// the scratch of a product is planned against a byte budget before
+// anything is allocated. with one branch the product runs the workspace
+// schedule above, whose temporaries are reused level by level. with w
+// branches the seven top level products are shared by w workers, each
+// holding its own operand sums, product and deeper workspace:
+//
+//     w (hm hk + hk hn + hm hn + workspace(hm, hk, hn, r - 1))
+//
+// elements. a branch adds its product into the quadrants of C under a
+// lock per quadrant and reuses its scratch for the next product, so
+// nothing else is allocated while multiplying. the plan takes the most
+// branches the pool can run, up to seven, and then the deepest
+// recursion that fits. a tight budget gets fewer branches, then fewer
+// levels, and at worst plain gemm with no scratch at all. peak_bytes()
+// reports the scratch that was allocated. the thread-local gemm packing
+// buffers are not counted.
+//
+//*************************************************************************//
+
+template<typename T>
+struct Capped_Strassen {
+
+    // dimensions, budget in bytes and the chosen depth and branch count
+    size_t m, k, n, budget, r, branches;
+
+    // thread pool reference
+    Thread_Pool<Matrix<T>>& TP;
+
+    // constructor, depth r_max and threads of the pool are upper limits
+    Capped_Strassen(size_t m_in, size_t k_in, size_t n_in, size_t r_max,
+                    size_t budget_in, size_t threads,
+                    Thread_Pool<Matrix<T>>& TP_in)
+
+        : m(m_in)
+        , k(k_in)
+        , n(n_in)
+        , budget(budget_in)
+        , r(0)
+        , branches(1)
+        , TP(TP_in)
+        , serial(0, 0, 0, 0) {
+
+        size_t width = std::min<size_t>(7, std::max<size_t>(1, threads));
+
+        bool planned = false;
+
+        // branches split the top level, so every dimension has to halve
+        if(m < 2 || k < 2 || n < 2) { width = 1; }
+
+        for(size_t w = width; w > 1 && !planned; --w) {
+
+            for(size_t d = r_max; d > 0 && !planned; --d) {
+
+                if(w * branch_size(d) * sizeof(T) <= budget) {
+
+                    r = d;
+                    branches = w;
+                    planned = true;
+                }
+            }
+        }
+
+        for(size_t d = r_max; d > 0 && !planned; --d) {
+
+            if(Workspace_Strassen<T>::workspace_size(m, k, n, d) * sizeof(T) <= budget) {
+
+                r = d;
+                planned = true;
+            }
+        }
+
+        if(branches == 1) {
+
+            serial = Workspace_Strassen<T>(m, k, n, r);
+
+        } else {
+
+            scratch.assign(branches, std::vector<T>(branch_size(r)));
+        }
+    }
+
+    // scratch elements of one branch at depth d
+    size_t branch_size(size_t d) const {
+
+        size_t hm = m / 2, hk = k / 2, hn = n / 2;
+
+        return hm * hk + hk * hn + hm * hn + Workspace_Strassen<T>::workspace_size(hm, hk, hn, d - 1);
+    }
+
+    // show scratch memory in bytes
+    size_t peak_bytes() const {
+
+        if(branches == 1) { return serial.peak_bytes(); }
+
+        return scratch.size() * scratch[0].size() * sizeof(T);
+    }
+
+    // C = A * B, or C += A * B if accumulating, for m x k and k x n views
+    void operator () (const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+                      const Matrix_View<T>& C, bool accumulate = false) {
+
+        if(A.rows() != m || A.columns() != k ||
+           B.rows() != k || B.columns() != n ||
+           C.rows() != m || C.columns() != n) {
+
+            throw std::out_of_range("incorrect dimensions for a Strassen product");
+        }
+
+        if(branches == 1) { serial(A, B, C, accumulate); return; }
+
+        size_t hm = m / 2, hn = n / 2;
+
+        // every product is added into the core
+        if(!accumulate) {
+
+            for(size_t i = 0; i < 2 * hm; ++i) { std::fill(&C(i, 0), &C(i, 0) + 2 * hn, T()); }
+        }
+
+        next = 0;
+
+        std::vector<Pool_Future<Matrix<T>>> f_B;
+
+        f_B.reserve(branches - 1);
+
+        try {
+
+            for(size_t b = 1; b < branches; ++b) {
+
+                f_B.push_back(TP.submit([this, &A, &B, &C, b] {
+
+                    work(A, B, C, scratch[b].data());
+
+                    return Matrix<T>();
+                }));
+            }
+
+            // the calling thread is branch 0, then helps the pool until the rest are done
+            work(A, B, C, scratch[0].data());
+
+        } catch(...) {
+
+            // the branches already queued use the operands and this, let them drain
+            for(size_t b = 0; b < f_B.size(); ++b) { f_B[b].wait(); }
+
+            throw;
+        }
+
+        // every branch has finished before a failed one is rethrown
+        for(size_t b = 0; b < f_B.size(); ++b) { f_B[b].wait(); }
+
+        for(size_t b = 0; b < f_B.size(); ++b) { f_B[b].get(); }
+
+        // odd rows, columns and inner dimension
+        strassen_peel(A, B, C, accumulate);
+    }
+
+    // C = A * B for matrices
+    template<typename Alloc>
+    void operator () (const Matrix<T, Alloc>& A, const Matrix<T, Alloc>& B, Matrix<T, Alloc>& C) {
+
+        (*this)(A.view(), B.view(), C.view());
+    }
+
+private:
+
+    // workspace used with a single branch
+    Workspace_Strassen<T> serial;
+
+    // scratch of every branch
+    std::vector<std::vector<T>> scratch;
+
+    // next of the seven products to take
+    std::atomic<size_t> next;
+
+    // one lock per quadrant of C
+    std::mutex quadrant_muter[4];
+
+    // take products until all seven are taken
+    void work(const Matrix_View<const T>& A, const Matrix_View<const T>& B,
+              const Matrix_View<T>& C, T* work_space) {
+
+        size_t hm = m / 2, hk = k / 2, hn = n / 2;
+
+        Matrix_View<const T> A11 = A.slice(0, hm, 0, hk);
+        Matrix_View<const T> A12 = A.slice(0, hm, hk, 2 * hk);
+        Matrix_View<const T> A21 = A.slice(hm, 2 * hm, 0, hk);
+        Matrix_View<const T> A22 = A.slice(hm, 2 * hm, hk, 2 * hk);
+
+        Matrix_View<const T> B11 = B.slice(0, hk, 0, hn);
+        Matrix_View<const T> B12 = B.slice(0, hk, hn, 2 * hn);
+        Matrix_View<const T> B21 = B.slice(hk, 2 * hk, 0, hn);
+        Matrix_View<const T> B22 = B.slice(hk, 2 * hk, hn, 2 * hn);
+
+        Matrix_View<T> C_q[4] = {
+
+            C.slice(0, hm, 0, hn), C.slice(0, hm, hn, 2 * hn),
+            C.slice(hm, 2 * hm, 0, hn), C.slice(hm, 2 * hm, hn, 2 * hn)
+        };
+
+        Matrix_View<T> X(work_space, hm, hk, hk);
+        Matrix_View<T> Y(work_space + hm * hk, hk, hn, hn);
+        Matrix_View<T> Z(work_space + hm * hk + hk * hn, hm, hn, hn);
+
+        T* deeper = work_space + hm * hk + hk * hn + hm * hn;
+
+        for(size_t q = next++; q < 7; q = next++) {
+
+            Matrix_View<const T> P = X;
+            Matrix_View<const T> Q = Y;
+
+            // signs of the product in C11, C12, C21 and C22
+            int signs[4] = { 0, 0, 0, 0 };
+
+            switch(q) {
+
+                // M1 = (A11 + A22) * (B11 + B22)
+                case 0: strassen_add(X, A11, A22); strassen_add(Y, B11, B22);
+                        signs[0] = 1; signs[3] = 1; break;
+
+                // M2 = (A21 + A22) * B11
+                case 1: strassen_add(X, A21, A22); Q = B11;
+                        signs[2] = 1; signs[3] = -1; break;
+
+                // M3 = A11 * (B12 - B22)
+                case 2: P = A11; strassen_subtract(Y, B12, B22);
+                        signs[1] = 1; signs[3] = 1; break;
+
+                // M4 = A22 * (B21 - B11)
+                case 3: P = A22; strassen_subtract(Y, B21, B11);
+                        signs[0] = 1; signs[2] = 1; break;
+
+                // M5 = (A11 + A12) * B22
+                case 4: strassen_add(X, A11, A12); Q = B22;
+                        signs[0] = -1; signs[1] = 1; break;
+
+                // M6 = (A21 - A11) * (B11 + B12)
+                case 5: strassen_subtract(X, A21, A11); strassen_add(Y, B11, B12);
+                        signs[3] = 1; break;
+
+                // M7 = (A12 - A22) * (B21 + B22)
+                default: strassen_subtract(X, A12, A22); strassen_add(Y, B21, B22);
+                         signs[0] = 1; break;
+            }
+
+            Workspace_Strassen<T>::recurse(P, Q, Z, r - 1, false, deeper);
+
+            for(size_t c = 0; c < 4; ++c) {
+
+                if(signs[c] == 0) { continue; }
+
+                std::lock_guard<std::mutex> lock(quadrant_muter[c]);
+
+                if(signs[c] > 0) { strassen_add_to(C_q[c], Z); }
+                else { strassen_subtract_from(C_q[c], Z); }
+            }
+        }
+    }
+
+};
+
+//*************************************************************************//
+//
+// calibration
+//
+// gemm is timed against one level of the workspace Strassen on square
+// sizes from max_size down to 64, best of a few runs each. the crossover
+// is the smallest size from which Strassen wins at every larger size, or
+// twice max_size if it never wins. Parallel_Strassen at the resulting
+// depth is then timed at max_size on pools of one thread up to the
+// hardware count, keeping the fastest pool size and parallel depth.
+//
+//*************************************************************************//
+
+// best of several timings of f
+template<typename F>
+double strassen_time(F f, size_t runs) {
+
+    Timer<double> Ti;
+
+    double best = 0.0;
+
+    for(size_t i = 0; i < runs; ++i) {
+
+        Ti.start();
+        f();
+        Ti.stop();
+
+        if(i == 0 || Ti.duration() < best) { best = Ti.duration(); }
+    }
+
+    return best;
+}
+
+// deterministic n x n operand with entries in [-1/2, 1/2)
+template<typename T>
+Matrix<T> strassen_operand(size_t n, size_t seed) {
+
+    Matrix<T> M(n, n, uninitialized);
+
+    for(size_t i = 0; i < n; ++i) {
+
+        for(size_t j = 0; j < n; ++j) {
+
+            M(i, j) = T((i * seed + j * 13) % 17) / T(17) - T(0.5);
+        }
+    }
+
+    return M;
+}
+
+// measure a profile for this host, install it as the current profile and
+// write it to file_name, an empty name skips writing
+template<typename T>
+Strassen_Profile strassen_calibrate(const std::string& file_name = strassen_profile_path(),
+                                    size_t max_size = 2048, size_t runs = 3) {
+
+    Strassen_Profile profile;
+
+    profile.crossover = 2 * max_size;
+
+    for(size_t n = max_size; n >= 64; n /= 2) {
+
+        Matrix<T> A = strassen_operand<T>(n, 7);
+        Matrix<T> B = strassen_operand<T>(n, 11);
+        Matrix<T> C(n, n, uninitialized);
+
+        Workspace_Strassen<T> WS(n, 1);
+
+        double t_gemm = strassen_time([&] {
+
+            strassen_gemm(A.view(), B.view(), C.view(), false);
+
+        }, runs);
+
+        double t_strassen = strassen_time([&] { WS(A, B, C); }, runs);
+
+        if(t_strassen >= t_gemm) { break; }
+
+        profile.crossover = n;
+    }
+
+    size_t r = profile.depth(max_size, max_size, max_size);
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    profile.threads = hardware;
+    profile.parallel_depth = 0;
+
+    if(r > 0) {
+
+        Matrix<T> A = strassen_operand<T>(max_size, 7);
+        Matrix<T> B = strassen_operand<T>(max_size, 11);
+
+        double best = 0.0;
+
+        for(size_t t = 1; ; t = std::min(2 * t, hardware)) {
+
+            Thread_Pool<Matrix<T>> TP(t, 'f', 1);
+
+            for(size_t p = 0; p < r && p < 3; ++p) {
+
+                double time = strassen_time([&] {
+
+                    Parallel_Strassen<T>(A, B, r, p, TP)();
+
+                }, runs);
+
+                if(best == 0.0 || time < best) {
+
+                    best = time;
+
+                    profile.threads = t;
+                    profile.parallel_depth = p;
+                }
+            }
+
+            if(t == hardware) { break; }
+        }
+    }
+
+    strassen_profile() = profile;
+
+    if(!file_name.empty()) { profile.save(file_name); }
+
+    return profile;
+}
+
+//*************************************************************************//
+
 #endif // STRASSEN_H_INCLUDED
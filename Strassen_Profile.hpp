@@ -0,0 +1,159 @@
+#ifndef STRASSEN_PROFILE_H_INCLUDED
+#define STRASSEN_PROFILE_H_INCLUDED
+
+//*************************************************************************//
+
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <cstddef>
+
+//*************************************************************************//
+//
+// machine profile for choosing Strassen depths
+//
+// whether a Strassen level pays off depends on how fast the base gemm is
+// on the host, so the crossover is measured rather than guessed. the
+// profile holds the smallest dimension at which one Strassen level beats
+// gemm, the parallel depth that was fastest and the pool size it was
+// measured on, from which depths for other pools are scaled. it is kept
+// in a small text file:
+//
+//     crossover 1024
+//     parallel_depth 1
+//     threads 4
+//
+// the file is read on first use from the path in the environment
+// variable MATRIX_STRASSEN_PROFILE, or from "strassen.profile" in the
+// working directory. strassen_calibrate in Strassen.hpp measures a new
+// profile. without a file the defaults below are used.
+//
+//*************************************************************************//
+
+struct Strassen_Profile {
+
+    // smallest dimension at which one Strassen level beats gemm
+    size_t crossover;
+
+    // levels run serially before the products are handed to the pool
+    size_t parallel_depth;
+
+    // pool size the parallel depth was measured with
+    size_t threads;
+
+    // defaults for hosts without a profile
+    Strassen_Profile()
+
+        : crossover(2048)
+        , parallel_depth(0)
+        , threads(2) {}
+
+    // read a profile, returns false and keeps the current values if the
+    // file cannot be opened or is malformed
+    bool load(const std::string& file_name) {
+
+        std::ifstream fin(file_name);
+
+        if(!fin.is_open()) { return false; }
+
+        Strassen_Profile read = *this;
+
+        std::string key;
+        size_t value;
+
+        while(fin >> key >> value) {
+
+            if(key == "crossover") { read.crossover = value; }
+            else if(key == "parallel_depth") { read.parallel_depth = value; }
+            else if(key == "threads") { read.threads = value; }
+            else { return false; }
+        }
+
+        if(!fin.eof() || read.crossover < 2) { return false; }
+
+        *this = read;
+
+        return true;
+    }
+
+    // write the profile, returns false if the file cannot be opened
+    bool save(const std::string& file_name) const {
+
+        std::ofstream fout(file_name);
+
+        if(!fout.is_open()) { return false; }
+
+        fout << "crossover " << crossover << "\n"
+             << "parallel_depth " << parallel_depth << "\n"
+             << "threads " << threads << "\n";
+
+        return static_cast<bool>(fout);
+    }
+
+    // recursion depth for an m x k by k x n product: a level is taken as
+    // long as every dimension is still at or above the crossover
+    size_t depth(size_t m, size_t k, size_t n) const {
+
+        size_t r = 0;
+
+        while(m >= crossover && k >= crossover && n >= crossover) {
+
+            m /= 2;
+            k /= 2;
+            n /= 2;
+
+            ++r;
+        }
+
+        return r;
+    }
+
+    // parallel depth for recursion depth r on a pool of pool_threads. a
+    // level more or less multiplies or divides the products by seven, so
+    // the measured depth moves by one for every factor of seven between
+    // the pool and the one it was measured with. the pool has to be
+    // reached before the recursion bottoms out in gemm
+    size_t parallel(size_t r, size_t pool_threads) const {
+
+        if(r == 0) { return 0; }
+
+        size_t p = parallel_depth;
+
+        size_t measured = threads > 0 ? threads : 1;
+
+        for(size_t t = measured; t * 7 <= pool_threads; t *= 7) { ++p; }
+
+        for(size_t t = pool_threads; p > 0 && t * 7 <= measured; t *= 7) { --p; }
+
+        return p < r ? p : r - 1;
+    }
+
+};
+
+// default location of the profile file
+inline std::string strassen_profile_path() {
+
+    const char* path = std::getenv("MATRIX_STRASSEN_PROFILE");
+
+    return path ? std::string(path) : std::string("strassen.profile");
+}
+
+// profile used by the automatic depth choice, loaded on first use. it
+// can be replaced, e.g. after calibrating, before products are started
+inline Strassen_Profile& strassen_profile() {
+
+    static Strassen_Profile profile = [] {
+
+        Strassen_Profile loaded;
+
+        loaded.load(strassen_profile_path());
+
+        return loaded;
+    }();
+
+    return profile;
+}
+
+//*************************************************************************//
+
+#endif // STRASSEN_PROFILE_H_INCLUDED
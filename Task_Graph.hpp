@@ -0,0 +1,440 @@
+#ifndef TASK_GRAPH_H_INCLUDED
+#define TASK_GRAPH_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <exception>
+#include <stdexcept>
+#include <atomic>
+
+#include "Thread_Pool_Core.hpp"
+
+//*************************************************************************//
+//
+// task graph
+//
+// nodes hold a callable and run once all the nodes before them have
+// finished. then() adds a node that receives the result of the node it
+// follows, and after() adds an edge without passing a result. every
+// node counts down its remaining predecessors atomically, and the node
+// that brings a count to zero schedules that successor, so no thread
+// ever blocks on an edge. a finishing node runs its first ready
+// successor itself and hands the others to the pool.
+//
+// a graph is built once and run as often as needed. run resets the
+// counters and queues the nodes without predecessors, results stay in
+// slots that later runs overwrite, so a repeated run allocates nothing
+// once every result slot has been filled. a graph may not be changed or
+// run again until its last run has finished. if a node throws, the
+// nodes not yet started are skipped and wait_all rethrows the first
+// exception.
+//
+//*************************************************************************//
+
+class Task_Graph;
+
+// storage for the result of a node, overwritten by every run
+template<typename R>
+struct Task_Slot {
+
+    std::unique_ptr<R> value;
+
+    void store(R&& r) {
+
+        if(value) { *value = std::move(r); }
+        else { value.reset(new R(std::move(r))); }
+    }
+};
+
+// run a callable and keep its result
+template<typename R, typename F>
+struct Task_Store {
+
+    std::shared_ptr<Task_Slot<R>> slot;
+
+    F f;
+
+    void operator()() { slot->store(f()); }
+};
+
+// run a callable on the result of the node before
+template<typename R, typename F>
+struct Task_Follow {
+
+    std::shared_ptr<Task_Slot<R>> input;
+
+    F f;
+
+    auto operator()() -> decltype(f(*input->value)) { return f(*input->value); }
+};
+
+//*************************************************************************//
+
+// handle to a node of a graph whose callable returns R
+template<typename R>
+class Task_Node {
+
+private:
+
+    friend class Task_Graph;
+
+    template<typename S>
+    friend class Task_Node;
+
+    Task_Graph* graph;
+
+    size_t index;
+
+    std::shared_ptr<Task_Slot<R>> slot;
+
+    Task_Node(Task_Graph* g, size_t i, const std::shared_ptr<Task_Slot<R>>& s)
+
+        : graph(g)
+        , index(i)
+        , slot(s) {}
+
+public:
+
+    Task_Node() : graph(0), index(0) {}
+
+    // position in the graph
+    size_t id() const { return index; }
+
+    // run only after other has finished
+    template<typename S>
+    Task_Node& after(const Task_Node<S>& other);
+
+    // result of the last run, valid once this node has finished
+    const R& get() const { return *slot->value; }
+
+    // add a node that calls f on the result of this one
+    template<typename F>
+    Task_Node<typename std::result_of<F(const R&)>::type> then(F f);
+
+};
+
+// handle to a node whose callable returns nothing
+template<>
+class Task_Node<void> {
+
+private:
+
+    friend class Task_Graph;
+
+    template<typename S>
+    friend class Task_Node;
+
+    Task_Graph* graph;
+
+    size_t index;
+
+    Task_Node(Task_Graph* g, size_t i)
+
+        : graph(g)
+        , index(i) {}
+
+public:
+
+    Task_Node() : graph(0), index(0) {}
+
+    size_t id() const { return index; }
+
+    template<typename S>
+    Task_Node& after(const Task_Node<S>& other);
+
+    // add a node that calls f once this one has finished
+    template<typename F>
+    Task_Node<typename std::result_of<F()>::type> then(F f);
+
+};
+
+//*************************************************************************//
+
+class Task_Graph {
+
+private:
+
+    template<typename R>
+    friend class Task_Node;
+
+    struct Vertex {
+
+        std::function<void()> work;
+
+        std::vector<size_t> successors;
+
+        size_t predecessors;
+
+        // predecessors still running in this run
+        std::atomic<size_t> waiting;
+
+        explicit Vertex(std::function<void()>&& w)
+
+            : work(std::move(w))
+            , predecessors(0)
+            , waiting(0) {}
+    };
+
+    std::vector<std::unique_ptr<Vertex>> vertices;
+
+    // vertices without predecessors, and their tasks for one run
+    std::vector<size_t> roots;
+
+    std::vector<Pool_Task*> root_tasks;
+
+    // roots are up to date and there is no cycle
+    bool checked;
+
+    // pool of the current run and whether a node has failed in it
+    Thread_Pool_Core* pool;
+
+    std::atomic_bool cancelled;
+
+    // runs one vertex on the pool, the latch counts the run's vertices
+    struct Step {
+
+        Task_Graph* graph;
+
+        size_t vertex;
+
+        std::shared_ptr<Pool_Latch> latch;
+
+        void operator()() { graph->step(vertex, latch); }
+    };
+
+    size_t insert(std::function<void()>&& work) {
+
+        vertices.push_back(std::unique_ptr<Vertex>(new Vertex(std::move(work))));
+
+        checked = false;
+
+        return vertices.size() - 1;
+    }
+
+    void link(size_t before, size_t after) {
+
+        vertices[before]->successors.push_back(after);
+
+        ++vertices[after]->predecessors;
+
+        checked = false;
+    }
+
+    // find the roots and reject cycles, which would never finish
+    void check() {
+
+        roots.clear();
+
+        std::vector<size_t> count(vertices.size());
+        std::vector<size_t> ready;
+
+        for(size_t v = 0; v < vertices.size(); ++v) {
+
+            count[v] = vertices[v]->predecessors;
+
+            if(count[v] == 0) { roots.push_back(v); ready.push_back(v); }
+        }
+
+        size_t reached = 0;
+
+        while(!ready.empty()) {
+
+            size_t v = ready.back();
+
+            ready.pop_back();
+
+            ++reached;
+
+            for(size_t s : vertices[v]->successors) {
+
+                if(--count[s] == 0) { ready.push_back(s); }
+            }
+        }
+
+        if(reached != vertices.size()) { throw std::logic_error("task graph has a cycle"); }
+
+        root_tasks.reserve(roots.size());
+
+        checked = true;
+    }
+
+    // run a vertex, then every successor it makes ready, the first of
+    // them on this thread
+    void step(size_t v, const std::shared_ptr<Pool_Latch>& latch) {
+
+        while(true) {
+
+            Vertex& x = *vertices[v];
+
+            if(!cancelled.load(std::memory_order_relaxed)) {
+
+                try { x.work(); }
+
+                catch(...) {
+
+                    cancelled = true;
+
+                    latch->fail(std::current_exception());
+                }
+            }
+
+            size_t next = vertices.size();
+
+            for(size_t s : x.successors) {
+
+                if(vertices[s]->waiting.fetch_sub(1, std::memory_order_acq_rel) != 1) { continue; }
+
+                if(next == vertices.size()) { next = s; continue; }
+
+                Step later = { this, s, latch };
+
+                try { pool->submit_front(pool_task(later)); }
+
+                catch(...) { step(s, latch); }
+            }
+
+            bool last = next == vertices.size();
+
+            // the run cannot end here while next is still counted, but
+            // without a next vertex this may be the final count, after
+            // which the graph may be gone
+            latch->count_down();
+
+            if(last) { return; }
+
+            v = next;
+        }
+    }
+
+public:
+
+    Task_Graph()
+
+        : checked(true)
+        , pool(0)
+        , cancelled(false) {}
+
+    Task_Graph(const Task_Graph&) = delete;
+
+    Task_Graph& operator = (const Task_Graph&) = delete;
+
+    ~Task_Graph() = default;
+
+    // number of nodes
+    size_t size() const { return vertices.size(); }
+
+    // add a node without predecessors that calls f
+    template<typename F>
+    typename std::enable_if<!std::is_void<typename std::result_of<F()>::type>::value,
+                            Task_Node<typename std::result_of<F()>::type>>::type add(F f) {
+
+        typedef typename std::result_of<F()>::type result_type;
+
+        std::shared_ptr<Task_Slot<result_type>> slot(new Task_Slot<result_type>());
+
+        Task_Store<result_type, F> work = { slot, std::move(f) };
+
+        return Task_Node<result_type>(this, insert(work), slot);
+    }
+
+    template<typename F>
+    typename std::enable_if<std::is_void<typename std::result_of<F()>::type>::value,
+                            Task_Node<void>>::type add(F f) {
+
+        return Task_Node<void>(this, insert(std::move(f)));
+    }
+
+    // queue the nodes without predecessors, wait_all on the handle waits
+    // for the whole graph while running pool tasks
+    Pool_Batch run(Thread_Pool_Core& p) {
+
+        if(!checked) { check(); }
+
+        if(vertices.empty()) { return Pool_Batch(); }
+
+        pool = &p;
+
+        cancelled = false;
+
+        for(size_t v = 0; v < vertices.size(); ++v) {
+
+            vertices[v]->waiting.store(vertices[v]->predecessors, std::memory_order_relaxed);
+        }
+
+        std::shared_ptr<Pool_Latch> latch = std::allocate_shared<Pool_Latch>(Pool_Allocator<Pool_Latch>(),
+                                                                             vertices.size());
+
+        root_tasks.clear();
+
+        try {
+
+            for(size_t r : roots) {
+
+                Step first = { this, r, latch };
+
+                root_tasks.push_back(pool_task(first));
+            }
+
+        } catch(...) {
+
+            for(size_t i = 0; i < root_tasks.size(); ++i) { delete root_tasks[i]; }
+
+            throw;
+        }
+
+        p.submit_batch(root_tasks.data(), root_tasks.size());
+
+        return Pool_Batch(latch, p);
+    }
+
+};
+
+//*************************************************************************//
+
+template<typename R>
+template<typename S>
+Task_Node<R>& Task_Node<R>::after(const Task_Node<S>& other) {
+
+    graph->link(other.index, index);
+
+    return *this;
+}
+
+template<typename S>
+Task_Node<void>& Task_Node<void>::after(const Task_Node<S>& other) {
+
+    graph->link(other.index, index);
+
+    return *this;
+}
+
+template<typename R>
+template<typename F>
+Task_Node<typename std::result_of<F(const R&)>::type> Task_Node<R>::then(F f) {
+
+    Task_Follow<R, F> follow = { slot, std::move(f) };
+
+    auto next = graph->add(std::move(follow));
+
+    next.after(*this);
+
+    return next;
+}
+
+template<typename F>
+Task_Node<typename std::result_of<F()>::type> Task_Node<void>::then(F f) {
+
+    auto next = graph->add(std::move(f));
+
+    next.after(*this);
+
+    return next;
+}
+
+//*************************************************************************//
+
+#endif // TASK_GRAPH_H_INCLUDED
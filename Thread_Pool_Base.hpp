@@ -0,0 +1,166 @@
+#ifndef THREAD_POOL_BASE_H_INCLUDED
+#define THREAD_POOL_BASE_H_INCLUDED
+
+//*************************************************************************//
+
+#include <memory>
+#include <future>
+
+#include "Thread_Pool_Core.hpp"
+#include "Parallel.hpp"
+#include "Task_Graph.hpp"
+
+//*************************************************************************//
+//
+// members shared by both thread pools
+//
+// tasks are scheduled by the work-stealing core in Thread_Pool_Core.hpp.
+// load_front from a worker pushes onto that worker's own deque, from
+// any other thread onto the lock-free front queue, and load_back onto
+// the lock-free back queue. both queues are bounded, load_front and
+// load_back wait for room while try_load_front and try_load_back
+// return an invalid future if the queue is full. load_batch and
+// load_range queue many tasks in one operation and return one Pool_Batch
+// whose wait_all waits for all of them.
+//
+// Thread_Pool_T.hpp and Thread_Pool_G.hpp only add the loading members,
+// which differ in the result type of their futures.
+//
+//*************************************************************************//
+
+class Thread_Pool_Base {
+
+protected:
+
+    // scheduler and worker threads
+    Thread_Pool_Core core;
+
+    // queue f, its result goes to a future of type R
+    template<typename R, typename F>
+    std::future<R> load(F f, bool front) {
+
+        // use a future for the result
+        std::future<R> result;
+
+        // push task onto the scheduler
+        if(front) { core.submit_front(pool_task(std::move(f), result)); }
+        else { core.submit_back(pool_task(std::move(f), result)); }
+
+        // return future with return type
+        return result;
+    }
+
+    // queue f like load, an invalid future means the queue was full and
+    // the task was not added
+    template<typename R, typename F>
+    std::future<R> try_load(F f, bool front) {
+
+        std::future<R> result;
+
+        std::unique_ptr<Pool_Task> queued(pool_task(std::move(f), result));
+
+        if(!(front ? core.try_submit_front(queued.get()) : core.try_submit_back(queued.get()))) {
+
+            return std::future<R>();
+        }
+
+        queued.release();
+
+        return result;
+    }
+
+public:
+
+    // basic constructors, idle workers park instead of sleeping so the
+    // time to sleep is accepted for compatibility and not used
+    Thread_Pool_Base(size_t t_n, char w_e,
+                     unsigned int, size_t q_c = 8192)
+
+        : core(t_n, w_e, q_c) {}
+
+    Thread_Pool_Base()
+
+        : core(2, 'f') {}
+
+    // deleted constructors
+    Thread_Pool_Base(const Thread_Pool_Base&) = delete;
+
+    Thread_Pool_Base(Thread_Pool_Base&&) = delete;
+
+    // deleted assingment operators
+    Thread_Pool_Base& operator = (const Thread_Pool_Base&) = delete;
+
+    Thread_Pool_Base& operator = (Thread_Pool_Base&&) = delete;
+
+    // destructor, joins the workers
+    ~Thread_Pool_Base() = default;
+
+    // number of worker threads
+    size_t size() const { return core.size(); }
+
+    // set work end
+    void set_work_end(char end) { core.set_work_end(end); }
+
+    // set time to sleep, not used
+    void set_time_to_sleep(unsigned int) {}
+
+    // tasks each injection queue holds
+    size_t queue_capacity() const { return core.queue_capacity(); }
+
+    // add task like load_front but without a future, for callers that
+    // track completion themselves. f must not throw
+    template<typename F>
+    void post_front(F f) { core.submit_front(pool_task(std::move(f))); }
+
+    // any future, waiting on it runs pool tasks
+    template<typename R>
+    Pool_Future<R> wrap(std::future<R> f) { return Pool_Future<R>(std::move(f), core); }
+
+    // add a task for every callable in first .. last in one operation,
+    // one handle tracks them all instead of a future each
+    template<typename Iterator>
+    Pool_Batch load_batch(Iterator first, Iterator last) { return pool_batch(core, first, last); }
+
+    // add a task calling f(begin, end) for every grain indices of
+    // first .. last as one batch, a grain of 0 picks one from the size
+    template<typename F>
+    Pool_Batch load_range(size_t first, size_t last, size_t grain, F f) {
+
+        return pool_range(core, first, last, grain, std::move(f));
+    }
+
+    // parallel loops on this pool, see Parallel.hpp
+    template<typename F>
+    void parallel_for(size_t first, size_t last, size_t grain, const F& body) {
+
+        ::parallel_for(core, first, last, grain, body);
+    }
+
+    template<typename F>
+    void parallel_for(size_t first, size_t last, size_t grain, const F& body, Parallel_Affinity& affinity) {
+
+        ::parallel_for(core, first, last, grain, body, affinity);
+    }
+
+    template<typename R, typename F, typename C>
+    R parallel_reduce(size_t first, size_t last, size_t grain, const R& identity, const F& body, const C& combine) {
+
+        return ::parallel_reduce(core, first, last, grain, identity, body, combine);
+    }
+
+    // start a task graph on this pool, see Task_Graph.hpp
+    Pool_Batch run(Task_Graph& graph) { return graph.run(core); }
+
+    // run one waiting task on the calling thread
+    bool work_front() { return core.work_front(); }
+
+    bool work_back() { return core.work_back(); }
+
+    // test if task queue is empty
+    bool is_empty() { return core.is_empty(); }
+
+};
+
+//*************************************************************************//
+
+#endif // THREAD_POOL_BASE_H_INCLUDED
@@ -0,0 +1,1508 @@
+#ifndef THREAD_POOL_CORE_H_INCLUDED
+#define THREAD_POOL_CORE_H_INCLUDED
+
+//*************************************************************************//
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <exception>
+#include <cstdint>
+
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+//*************************************************************************//
+//
+// work-stealing scheduler shared by both thread pools
+//
+// every worker owns a Chase-Lev deque. it pushes and pops tasks at the
+// bottom, last in first out, so nested work stays hot in its cache,
+// while idle workers steal the oldest task from the top of a random
+// victim's deque. a task submitted from a worker lands on that worker's
+// own deque, so fork-join code never touches a shared lock.
+//
+// tasks from threads outside the pool go through two bounded lock-free
+// injection queues, one for load_front and one for load_back, so many
+// outside submitters never share a lock. workers look in their own
+// deque first, then the injection queues, the front queue first or the
+// back queue first as set by work_end, and steal last. every worker
+// also has a mailbox for tasks meant for it in particular, which it
+// reads right after its own deque and thieves read after its deque. a
+// full queue pushes back on the submitter: load_front and load_back
+// wait for room, try_load_front and try_load_back refuse the task.
+//
+// a worker that finds nothing spins for a few rounds with the pause
+// instruction, then yields, then parks on a condition variable. every
+// submission wakes exactly one parked worker, so a task sent to an idle
+// pool starts within microseconds and idle workers use no CPU.
+//
+// tasks and the shared state of their futures are built in recycled
+// blocks, see the block cache below, so submitting a small callable
+// does not touch the heap once the pool has warmed up.
+//
+//*************************************************************************//
+
+// spin-wait hint to the processor
+inline void pool_pause() {
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#endif
+}
+
+//*************************************************************************//
+//
+// block cache
+//
+// fixed-size blocks of 64, 128 and 256 bytes are kept on a free list per
+// thread instead of going back to the heap. a thread that frees more
+// than it uses, like a worker running tasks that an outside thread
+// allocated, hands a batch to a shared list, and a thread that runs dry
+// takes a batch back, so the lock is taken once per batch. larger
+// requests go to the heap.
+//
+//*************************************************************************//
+
+template<size_t Size>
+class Pool_Block_Cache {
+
+private:
+
+    struct Block { Block* next; };
+
+    enum { batch = 32 };
+
+    // batches of blocks any thread may take
+    struct Shared {
+
+        std::mutex muter;
+
+        std::vector<Block*> batches;
+    };
+
+    // blocks owned by one thread, given back to the shared list at exit
+    struct Local {
+
+        Block* head;
+
+        size_t count;
+
+        Local() : head(0), count(0) {}
+
+        ~Local() {
+
+            if(!head) { return; }
+
+            Shared& s = shared();
+
+            std::lock_guard<std::mutex> lock(s.muter);
+
+            s.batches.push_back(head);
+        }
+    };
+
+    // never destroyed, a pool with static storage duration may still
+    // be joining workers that hand their blocks back
+    static Shared& shared() {
+
+        static Shared* s = new Shared();
+
+        return *s;
+    }
+
+    static Local& local() {
+
+        static thread_local Local l;
+
+        return l;
+    }
+
+    static size_t length(Block* block) {
+
+        size_t n = 0;
+
+        for(; block; block = block->next) { ++n; }
+
+        return n;
+    }
+
+public:
+
+    static void* allocate() {
+
+        Local& l = local();
+
+        if(!l.head) {
+
+            Shared& s = shared();
+
+            std::lock_guard<std::mutex> lock(s.muter);
+
+            if(!s.batches.empty()) {
+
+                l.head = s.batches.back();
+
+                s.batches.pop_back();
+
+                l.count = length(l.head);
+            }
+        }
+
+        if(!l.head) { return ::operator new(Size); }
+
+        Block* block = l.head;
+
+        l.head = block->next;
+
+        --l.count;
+
+        return block;
+    }
+
+    static void deallocate(void* p) {
+
+        Local& l = local();
+
+        Block* block = static_cast<Block*>(p);
+
+        block->next = l.head;
+
+        l.head = block;
+
+        if(++l.count < 2 * batch) { return; }
+
+        // keep one batch, share the other
+        Block* last = l.head;
+
+        for(size_t i = 1; i < batch; ++i) { last = last->next; }
+
+        Block* rest = last->next;
+
+        last->next = 0;
+
+        l.count = batch;
+
+        Shared& s = shared();
+
+        std::lock_guard<std::mutex> lock(s.muter);
+
+        s.batches.push_back(rest);
+    }
+
+};
+
+// memory for tasks and future states, from the smallest block that fits
+inline void* pool_allocate(size_t size) {
+
+    if(size <= 64) { return Pool_Block_Cache<64>::allocate(); }
+
+    if(size <= 128) { return Pool_Block_Cache<128>::allocate(); }
+
+    if(size <= 256) { return Pool_Block_Cache<256>::allocate(); }
+
+    return ::operator new(size);
+}
+
+inline void pool_deallocate(void* p, size_t size) {
+
+    if(size <= 64) { Pool_Block_Cache<64>::deallocate(p); }
+    else if(size <= 128) { Pool_Block_Cache<128>::deallocate(p); }
+    else if(size <= 256) { Pool_Block_Cache<256>::deallocate(p); }
+    else { ::operator delete(p); }
+}
+
+// allocator over the block cache, for the shared state of a promise
+template<typename T>
+struct Pool_Allocator {
+
+    typedef T value_type;
+
+    Pool_Allocator() {}
+
+    template<typename U>
+    Pool_Allocator(const Pool_Allocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool_allocate(n * sizeof(T))); }
+
+    void deallocate(T* p, size_t n) { pool_deallocate(p, n * sizeof(T)); }
+};
+
+template<typename T, typename U>
+bool operator == (const Pool_Allocator<T>&, const Pool_Allocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator != (const Pool_Allocator<T>&, const Pool_Allocator<U>&) { return false; }
+
+//*************************************************************************//
+//
+// tasks
+//
+//*************************************************************************//
+
+// a unit of work, destroyed after it has run. a task whose callable is
+// small lives whole in one cached block, deleting it through the base
+// passes the size of the full task back to the cache
+struct Pool_Task {
+
+    virtual ~Pool_Task() {}
+
+    virtual void run() = 0;
+
+    static void* operator new(size_t size) { return pool_allocate(size); }
+
+    static void operator delete(void* p, size_t size) { pool_deallocate(p, size); }
+};
+
+template<typename F>
+struct Pool_Task_Of : Pool_Task {
+
+    F f;
+
+    explicit Pool_Task_Of(F&& f_in) : f(std::move(f_in)) {}
+
+    void run() { f(); }
+};
+
+// wrap a callable as a task
+template<typename F>
+Pool_Task* pool_task(F f) { return new Pool_Task_Of<F>(std::move(f)); }
+
+// run a callable and keep its result or exception in a promise
+template<typename R, typename F>
+struct Pool_Call {
+
+    std::promise<R> promise;
+
+    F f;
+
+    Pool_Call(std::promise<R>&& p, F&& f_in) : promise(std::move(p)), f(std::move(f_in)) {}
+
+    void operator()() {
+
+        try { promise.set_value(f()); }
+
+        catch(...) { promise.set_exception(std::current_exception()); }
+    }
+};
+
+template<typename F>
+struct Pool_Call<void, F> {
+
+    std::promise<void> promise;
+
+    F f;
+
+    Pool_Call(std::promise<void>&& p, F&& f_in) : promise(std::move(p)), f(std::move(f_in)) {}
+
+    void operator()() {
+
+        try { f(); promise.set_value(); }
+
+        catch(...) { promise.set_exception(std::current_exception()); }
+    }
+};
+
+// wrap a callable as a task whose result is delivered to result, the
+// promise keeps its shared state in the block cache
+template<typename R, typename F>
+Pool_Task* pool_task(F f, std::future<R>& result) {
+
+    std::promise<R> promise(std::allocator_arg, Pool_Allocator<char>());
+
+    result = promise.get_future();
+
+    return pool_task(Pool_Call<R, F>(std::move(promise), std::move(f)));
+}
+
+//*************************************************************************//
+//
+// Chase-Lev deque
+//
+// after Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient
+// Work-Stealing for Weak Memory Models". only the owner calls push and
+// pop, any thread may call steal. a full ring is replaced by one of
+// twice the size, and old rings are kept until the deque is destroyed
+// since a thief may still be reading from one.
+//
+//*************************************************************************//
+
+class Work_Stealing_Deque {
+
+private:
+
+    // circular array of task pointers
+    struct Ring {
+
+        size_t mask;
+
+        std::unique_ptr<std::atomic<Pool_Task*>[]> slots;
+
+        explicit Ring(size_t capacity)
+
+            : mask(capacity - 1)
+            , slots(new std::atomic<Pool_Task*>[capacity]) {}
+
+        size_t capacity() const { return mask + 1; }
+
+        Pool_Task* get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+
+        void put(int64_t i, Pool_Task* t) { slots[i & mask].store(t, std::memory_order_relaxed); }
+    };
+
+    // next index to steal from and next index to push to
+    std::atomic<int64_t> top, bottom;
+
+    std::atomic<Ring*> ring;
+
+    // every ring ever used, owned by the deque
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    // copy the live tasks into a ring of twice the size
+    Ring* grow(Ring* old, int64_t t, int64_t b) {
+
+        std::unique_ptr<Ring> bigger(new Ring(2 * old->capacity()));
+
+        for(int64_t i = t; i < b; ++i) { bigger->put(i, old->get(i)); }
+
+        Ring* r = bigger.get();
+
+        rings.push_back(std::move(bigger));
+
+        ring.store(r, std::memory_order_release);
+
+        return r;
+    }
+
+public:
+
+    explicit Work_Stealing_Deque(size_t capacity = 256)
+
+        : top(0)
+        , bottom(0) {
+
+        rings.push_back(std::unique_ptr<Ring>(new Ring(capacity)));
+
+        ring.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    Work_Stealing_Deque(const Work_Stealing_Deque&) = delete;
+
+    Work_Stealing_Deque& operator = (const Work_Stealing_Deque&) = delete;
+
+    // owner only, add a task at the bottom
+    void push(Pool_Task* task) {
+
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+
+        Ring* r = ring.load(std::memory_order_relaxed);
+
+        if(b - t >= static_cast<int64_t>(r->capacity())) { r = grow(r, t, b); }
+
+        r->put(b, task);
+
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only, take the newest task, or 0
+    Pool_Task* pop() {
+
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+
+        Ring* r = ring.load(std::memory_order_relaxed);
+
+        bottom.store(b, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if(t > b) {
+
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+
+            return 0;
+        }
+
+        Pool_Task* task = r->get(b);
+
+        if(t == b) {
+
+            // last task, race the thieves for it
+            if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed)) { task = 0; }
+
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    // any thread, take the oldest task, or 0 if empty or lost to another thief
+    Pool_Task* steal() {
+
+        int64_t t = top.load(std::memory_order_acquire);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if(t >= b) { return 0; }
+
+        Pool_Task* task = ring.load(std::memory_order_acquire)->get(t);
+
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) { return 0; }
+
+        return task;
+    }
+
+    // approximate number of tasks
+    size_t size() const {
+
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+};
+
+//*************************************************************************//
+//
+// bounded multi-producer multi-consumer queue
+//
+// after Vyukov's bounded MPMC queue. every cell carries a sequence number
+// that tells producers and consumers whose turn it is, so push and pop
+// each take one compare-and-swap on their own index and never lock. the
+// capacity is fixed, push fails instead of growing when the queue is
+// full.
+//
+//*************************************************************************//
+
+class Injection_Queue {
+
+private:
+
+    struct Cell {
+
+        std::atomic<size_t> sequence;
+
+        Pool_Task* task;
+    };
+
+    size_t mask;
+
+    std::unique_ptr<Cell[]> cells;
+
+    // producer and consumer indices on separate cache lines
+    char pad_0[64];
+
+    std::atomic<size_t> enqueue_index;
+
+    char pad_1[64 - sizeof(std::atomic<size_t>)];
+
+    std::atomic<size_t> dequeue_index;
+
+    char pad_2[64 - sizeof(std::atomic<size_t>)];
+
+public:
+
+    // capacity is rounded up to a power of two
+    explicit Injection_Queue(size_t capacity)
+
+        : enqueue_index(0)
+        , dequeue_index(0) {
+
+        size_t n = 2;
+
+        while(n < capacity) { n *= 2; }
+
+        mask = n - 1;
+
+        cells.reset(new Cell[n]);
+
+        for(size_t i = 0; i < n; ++i) {
+
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+
+            cells[i].task = 0;
+        }
+    }
+
+    Injection_Queue(const Injection_Queue&) = delete;
+
+    Injection_Queue& operator = (const Injection_Queue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // add a task at the tail, false if the queue is full
+    bool push(Pool_Task* task) {
+
+        size_t index = enqueue_index.load(std::memory_order_relaxed);
+
+        Cell* cell;
+
+        while(true) {
+
+            cell = &cells[index & mask];
+
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(index);
+
+            if(difference == 0) {
+
+                if(enqueue_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) { break; }
+
+            } else if(difference < 0) {
+
+                // the consumers have not freed this cell yet
+                return false;
+
+            } else {
+
+                index = enqueue_index.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->task = task;
+
+        cell->sequence.store(index + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // add up to n tasks at the tail with one compare-and-swap, returns
+    // how many fit, 0 if the queue is full
+    size_t push_batch(Pool_Task* const* tasks, size_t n) {
+
+        size_t index = enqueue_index.load(std::memory_order_relaxed);
+
+        size_t k;
+
+        while(true) {
+
+            // count the free cells from index on, they stay free for as
+            // long as enqueue_index does not move
+            k = 0;
+
+            while(k < n && k <= mask &&
+                  cells[(index + k) & mask].sequence.load(std::memory_order_acquire) == index + k) { ++k; }
+
+            if(k == 0) {
+
+                size_t sequence = cells[index & mask].sequence.load(std::memory_order_acquire);
+
+                if(static_cast<intptr_t>(sequence) - static_cast<intptr_t>(index) < 0) { return 0; }
+
+                index = enqueue_index.load(std::memory_order_relaxed);
+
+                continue;
+            }
+
+            if(enqueue_index.compare_exchange_weak(index, index + k, std::memory_order_relaxed)) { break; }
+        }
+
+        for(size_t i = 0; i < k; ++i) {
+
+            Cell& cell = cells[(index + i) & mask];
+
+            cell.task = tasks[i];
+
+            cell.sequence.store(index + i + 1, std::memory_order_release);
+        }
+
+        return k;
+    }
+
+    // take the task at the head, or 0 if the queue is empty
+    Pool_Task* pop() {
+
+        size_t index = dequeue_index.load(std::memory_order_relaxed);
+
+        Cell* cell;
+
+        while(true) {
+
+            cell = &cells[index & mask];
+
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(index + 1);
+
+            if(difference == 0) {
+
+                if(dequeue_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) { break; }
+
+            } else if(difference < 0) {
+
+                // no producer has filled this cell yet
+                return 0;
+
+            } else {
+
+                index = dequeue_index.load(std::memory_order_relaxed);
+            }
+        }
+
+        Pool_Task* task = cell->task;
+
+        // free the cell for the producer one lap ahead
+        cell->sequence.store(index + mask + 1, std::memory_order_release);
+
+        return task;
+    }
+
+    // approximate number of tasks
+    size_t size() const {
+
+        size_t d = dequeue_index.load(std::memory_order_relaxed);
+        size_t e = enqueue_index.load(std::memory_order_relaxed);
+
+        return e > d ? e - d : 0;
+    }
+
+};
+
+//*************************************************************************//
+//
+// scheduler
+//
+//*************************************************************************//
+
+class Thread_Pool_Core {
+
+private:
+
+    // a worker thread and its deque
+    struct Worker {
+
+        Work_Stealing_Deque tasks;
+
+        // tasks sent to this worker by submit_affine
+        Injection_Queue mailbox;
+
+        std::thread thread;
+
+        Worker() : mailbox(256) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // used to signify the time to clean up
+    std::atomic_bool done;
+
+    // workers take injected tasks from the front queue or the back queue first
+    std::atomic<char> work_end;
+
+    // parked workers and the wakeups sent to them
+    std::atomic<size_t> sleepers;
+
+    uint64_t wakeups;
+
+    std::mutex park_muter;
+
+    std::condition_variable park_condition;
+
+    // tasks from threads outside the pool, and load_back from workers
+    Injection_Queue injected_front;
+
+    Injection_Queue injected_back;
+
+    // the pool and worker index of the calling thread, if it is a worker
+    struct Worker_Identity {
+
+        const Thread_Pool_Core* pool;
+
+        size_t index;
+    };
+
+    static Worker_Identity& identity() {
+
+        static thread_local Worker_Identity id = { 0, 0 };
+
+        return id;
+    }
+
+    // xorshift state for choosing victims, one per thread
+    static uint32_t next_random() {
+
+        static thread_local uint32_t state =
+
+            static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return state;
+    }
+
+    // index of the calling worker in this pool, or workers.size()
+    size_t own_index() const {
+
+        const Worker_Identity& id = identity();
+
+        return id.pool == this ? id.index : workers.size();
+    }
+
+    Pool_Task* take_injected(bool front) {
+
+        Injection_Queue& first = front ? injected_front : injected_back;
+        Injection_Queue& second = front ? injected_back : injected_front;
+
+        Pool_Task* task = first.pop();
+
+        if(!task) { task = second.pop(); }
+
+        return task;
+    }
+
+    // queue a task for the pool, a full queue falls back on the calling
+    // worker's own deque, or is refused for any other thread
+    bool inject(Injection_Queue& queue, Pool_Task* task, size_t index) {
+
+        if(queue.push(task)) { return true; }
+
+        if(index < workers.size()) {
+
+            workers[index]->tasks.push(task);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // queue a task, waiting for room while the queue is full
+    void inject_waiting(Injection_Queue& queue, Pool_Task* task, size_t index) {
+
+        try {
+
+            for(size_t misses = 0; !inject(queue, task, index); ++misses) {
+
+                wake_one();
+
+                if(misses < 64) { pool_pause(); }
+                else { std::this_thread::yield(); }
+            }
+
+        } catch(...) {
+
+            delete task;
+
+            throw;
+        }
+
+        wake_one();
+    }
+
+    // queue a task if there is room, the task stays with the caller if not
+    bool inject_trying(Injection_Queue& queue, Pool_Task* task, size_t index) {
+
+        if(!inject(queue, task, index)) { return false; }
+
+        wake_one();
+
+        return true;
+    }
+
+    // try every other worker once, starting from a random victim
+    Pool_Task* steal(size_t thief) {
+
+        size_t n = workers.size();
+
+        if(n == 0) { return 0; }
+
+        size_t start = next_random() % n;
+
+        for(size_t i = 0; i < n; ++i) {
+
+            size_t victim = (start + i) % n;
+
+            if(victim == thief) { continue; }
+
+            Pool_Task* task = workers[victim]->tasks.steal();
+
+            if(!task) { task = workers[victim]->mailbox.pop(); }
+
+            if(task) { return task; }
+        }
+
+        return 0;
+    }
+
+    // find a task: own deque and mailbox, then injected tasks, then
+    // other deques and mailboxes
+    Pool_Task* find(bool front) {
+
+        size_t index = own_index();
+
+        Pool_Task* task = 0;
+
+        if(index < workers.size()) {
+
+            task = workers[index]->tasks.pop();
+
+            if(!task) { task = workers[index]->mailbox.pop(); }
+        }
+
+        if(!task) { task = take_injected(front); }
+
+        if(!task) { task = steal(index); }
+
+        return task;
+    }
+
+    // tasks run inside other tasks' waits on the calling thread. a thread
+    // that helps while it waits may pick up any task, which may wait and
+    // help in turn, so helping stops at max_nesting to bound the stack
+    enum { max_nesting = 128 };
+
+    static size_t& nesting() {
+
+        static thread_local size_t depth = 0;
+
+        return depth;
+    }
+
+    static void execute(Pool_Task* task) {
+
+        std::unique_ptr<Pool_Task> owner(task);
+
+        size_t& depth = nesting();
+
+        ++depth;
+
+        try { task->run(); } catch(...) { --depth; throw; }
+
+        --depth;
+    }
+
+    // wake one parked worker after a task was made visible
+    void wake_one() {
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if(sleepers.load(std::memory_order_relaxed) == 0) { return; }
+
+        {
+            std::lock_guard<std::mutex> lock(park_muter);
+
+            ++wakeups;
+        }
+
+        park_condition.notify_one();
+    }
+
+    // wake up to n parked workers after n tasks were made visible
+    void wake_some(size_t n) {
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        size_t parked = sleepers.load(std::memory_order_relaxed);
+
+        if(parked == 0) { return; }
+
+        {
+            std::lock_guard<std::mutex> lock(park_muter);
+
+            ++wakeups;
+        }
+
+        if(n >= parked) { park_condition.notify_all(); }
+        else { for(size_t i = 0; i < n; ++i) { park_condition.notify_one(); } }
+    }
+
+    // look for a task while spinning, then yielding, then parked
+    Pool_Task* idle(bool front) {
+
+        for(size_t round = 0; round < 64 && !done; ++round) {
+
+            if(Pool_Task* task = find(front)) { return task; }
+
+            size_t pauses = size_t(1) << (round < 6 ? round : 6);
+
+            for(size_t i = 0; i < pauses; ++i) { pool_pause(); }
+        }
+
+        for(size_t round = 0; round < 16 && !done; ++round) {
+
+            if(Pool_Task* task = find(front)) { return task; }
+
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(park_muter);
+
+        uint64_t seen = wakeups;
+
+        lock.unlock();
+
+        // announce the park before the last look, a submitter that misses
+        // the task in flight sees the sleeper and sends a wakeup
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        Pool_Task* task = find(front);
+
+        if(!task) {
+
+            lock.lock();
+
+            while(wakeups == seen && !done) { park_condition.wait(lock); }
+
+            lock.unlock();
+        }
+
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+        return task;
+    }
+
+    // causes a thread to repetitively perform tasks
+    void looper(size_t index) {
+
+        identity().pool = this;
+        identity().index = index;
+
+        while(!done) {
+
+            bool front = work_end.load(std::memory_order_relaxed) == 'f';
+
+            Pool_Task* task = find(front);
+
+            if(!task) { task = idle(front); }
+
+            if(task) { execute(task); }
+        }
+    }
+
+public:
+
+    // constructor, each injection queue holds queue_capacity tasks
+    Thread_Pool_Core(size_t thread_number, char w_e, size_t queue_capacity = 8192)
+
+        : done(false)
+        , work_end(w_e)
+        , sleepers(0)
+        , wakeups(0)
+        , injected_front(queue_capacity)
+        , injected_back(queue_capacity) {
+
+        for(size_t i = 0; i < thread_number; ++i) {
+
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        }
+
+        try {
+
+            for(size_t i = 0; i < thread_number; ++i) {
+
+                workers[i]->thread = std::thread(&Thread_Pool_Core::looper, this, i);
+            }
+
+        } catch(...) {
+
+            stop();
+
+            throw;
+        }
+    }
+
+    Thread_Pool_Core(const Thread_Pool_Core&) = delete;
+
+    Thread_Pool_Core& operator = (const Thread_Pool_Core&) = delete;
+
+    // destructor, tasks that never ran are destroyed unrun
+    ~Thread_Pool_Core() { stop(); }
+
+    // number of worker threads
+    size_t size() const { return workers.size(); }
+
+    // set work end
+    void set_work_end(char end) { work_end = end; }
+
+    // hand a task to the pool, a worker pushes onto its own deque where
+    // the newest task is run first, any other thread onto the front
+    // queue, waiting while it is full
+    void submit_front(Pool_Task* task) {
+
+        size_t index = own_index();
+
+        if(index < workers.size()) {
+
+            try {
+
+                workers[index]->tasks.push(task);
+
+            } catch(...) {
+
+                delete task;
+
+                throw;
+            }
+
+            wake_one();
+
+        } else {
+
+            inject_waiting(injected_front, task, index);
+        }
+    }
+
+    // hand a task to the pool through the back queue, waiting while it is full
+    void submit_back(Pool_Task* task) { inject_waiting(injected_back, task, own_index()); }
+
+    // like submit_front and submit_back, but return false and leave the
+    // task with the caller if its queue is full
+    bool try_submit_front(Pool_Task* task) {
+
+        size_t index = own_index();
+
+        if(index < workers.size()) {
+
+            workers[index]->tasks.push(task);
+
+            wake_one();
+
+            return true;
+        }
+
+        return inject_trying(injected_front, task, index);
+    }
+
+    bool try_submit_back(Pool_Task* task) { return inject_trying(injected_back, task, own_index()); }
+
+    // hand n tasks to the pool at once, a worker pushes them onto its own
+    // deque, any other thread onto the back queue in as few steps as the
+    // free room allows, waiting while it is full
+    void submit_batch(Pool_Task* const* tasks, size_t n) {
+
+        size_t index = own_index();
+
+        size_t queued = 0;
+
+        try {
+
+            if(index < workers.size()) {
+
+                for(; queued < n; ++queued) { workers[index]->tasks.push(tasks[queued]); }
+
+            } else {
+
+                for(size_t misses = 0; queued < n; ) {
+
+                    size_t k = injected_back.push_batch(tasks + queued, n - queued);
+
+                    if(k != 0) { queued += k; misses = 0; wake_some(k); continue; }
+
+                    wake_some(n - queued);
+
+                    if(++misses < 64) { pool_pause(); }
+                    else { std::this_thread::yield(); }
+                }
+            }
+
+        } catch(...) {
+
+            for(size_t i = queued; i < n; ++i) { delete tasks[i]; }
+
+            throw;
+        }
+
+        wake_some(n);
+    }
+
+    // hand task i to worker owners[i] through its mailbox, where that
+    // worker looks first once its own deque is empty. an owner that is
+    // not a worker, or a full mailbox, sends the task to the front queue
+    void submit_affine(const size_t* owners, Pool_Task* const* tasks, size_t n) {
+
+        size_t queued = 0;
+
+        try {
+
+            for(; queued < n; ++queued) {
+
+                size_t owner = owners[queued];
+
+                if(owner < workers.size() && workers[owner]->mailbox.push(tasks[queued])) { continue; }
+
+                submit_front(tasks[queued]);
+            }
+
+        } catch(...) {
+
+            // submit_front deleted the task it failed on
+            for(size_t i = queued + 1; i < n; ++i) { delete tasks[i]; }
+
+            throw;
+        }
+
+        // the owners may be parked, wake them all
+        wake_some(workers.size());
+    }
+
+    // capacity of each injection queue
+    size_t queue_capacity() const { return injected_back.capacity(); }
+
+    // index of the calling thread among the workers, or size() for any
+    // other thread
+    size_t worker_index() const { return own_index(); }
+
+    // test if the calling thread is running a task of any pool, or is
+    // a worker of one
+    static bool in_task() { return nesting() > 0 || identity().pool != 0; }
+
+    // run one task on the calling thread, injected tasks are taken from
+    // the front queue or the back queue first. returns false if none was
+    // found, or if the thread is already max_nesting tasks deep
+    bool work_front() {
+
+        if(nesting() >= max_nesting) { return false; }
+
+        Pool_Task* task = find(true);
+
+        if(!task) { return false; }
+
+        execute(task);
+
+        return true;
+    }
+
+    bool work_back() {
+
+        if(nesting() >= max_nesting) { return false; }
+
+        Pool_Task* task = find(false);
+
+        if(!task) { return false; }
+
+        execute(task);
+
+        return true;
+    }
+
+    // test if no task is waiting
+    bool is_empty() const {
+
+        if(injected_front.size() != 0 || injected_back.size() != 0) { return false; }
+
+        for(size_t i = 0; i < workers.size(); ++i) {
+
+            if(workers[i]->tasks.size() != 0 || workers[i]->mailbox.size() != 0) { return false; }
+        }
+
+        return true;
+    }
+
+    // join the workers and destroy tasks that never ran
+    void stop() {
+
+        {
+            std::lock_guard<std::mutex> lock(park_muter);
+
+            done = true;
+        }
+
+        park_condition.notify_all();
+
+        for(size_t i = 0; i < workers.size(); ++i) {
+
+            if(workers[i]->thread.joinable()) { workers[i]->thread.join(); }
+        }
+
+        for(size_t i = 0; i < workers.size(); ++i) {
+
+            while(Pool_Task* task = workers[i]->tasks.steal()) { delete task; }
+
+            while(Pool_Task* task = workers[i]->mailbox.pop()) { delete task; }
+        }
+
+        while(Pool_Task* task = injected_front.pop()) { delete task; }
+
+        while(Pool_Task* task = injected_back.pop()) { delete task; }
+    }
+
+};
+
+//*************************************************************************//
+//
+// pool future
+//
+// a future whose wait and get run other pool tasks on the calling thread
+// until the result is ready. a worker waiting on a task it submitted
+// pops its own deque first, so nested fork-join keeps every worker busy
+// and cannot deadlock a pool whose workers are all waiting. with
+// nothing left to run it yields, then blocks on the result in short
+// slices so that new tasks are still picked up.
+//
+//*************************************************************************//
+
+template<typename R>
+class Pool_Future {
+
+private:
+
+    std::future<R> result;
+
+    Thread_Pool_Core* pool;
+
+public:
+
+    // constructors
+    Pool_Future() : pool(0) {}
+
+    Pool_Future(std::future<R>&& f, Thread_Pool_Core& p)
+
+        : result(std::move(f))
+        , pool(&p) {}
+
+    // move only
+    Pool_Future(Pool_Future&&) = default;
+
+    Pool_Future& operator = (Pool_Future&&) = default;
+
+    // test for a shared state
+    bool valid() const { return result.valid(); }
+
+    // test if the result is available
+    bool is_ready() const {
+
+        return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // run pool tasks until the result is available
+    void wait() const {
+
+        if(!pool) { result.wait(); return; }
+
+        size_t misses = 0;
+
+        while(!is_ready()) {
+
+            if(pool->work_front()) { misses = 0; continue; }
+
+            if(++misses < 16) { std::this_thread::yield(); }
+            else { result.wait_for(std::chrono::microseconds(100)); }
+        }
+    }
+
+    // wait, then take the result or rethrow the task's exception
+    R get() {
+
+        wait();
+
+        return result.get();
+    }
+
+    // the plain future, whose waits no longer help the pool
+    std::future<R> release() { return std::move(result); }
+
+};
+
+//*************************************************************************//
+//
+// batch latch
+//
+// one completion handle for a whole batch of tasks in place of a future
+// each. every task counts the latch down when it finishes and the first
+// exception thrown by any of them is kept. wait_all runs pool tasks on
+// the calling thread like Pool_Future::wait, then rethrows that
+// exception.
+//
+//*************************************************************************//
+
+class Pool_Latch {
+
+private:
+
+    std::atomic<size_t> pending;
+
+    std::atomic_bool failed;
+
+    std::exception_ptr error;
+
+    std::mutex muter;
+
+    std::condition_variable condition;
+
+public:
+
+    explicit Pool_Latch(size_t n)
+
+        : pending(n)
+        , failed(false) {}
+
+    // more tasks, only while at least one counted task is still running
+    void add(size_t n) { pending.fetch_add(n, std::memory_order_relaxed); }
+
+    // keep the first exception only
+    void fail(std::exception_ptr e) { if(!failed.exchange(true)) { error = e; } }
+
+    void count_down() {
+
+        if(pending.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+
+        std::lock_guard<std::mutex> lock(muter);
+
+        condition.notify_all();
+    }
+
+    size_t remaining() const { return pending.load(std::memory_order_acquire); }
+
+    // block for at most d or until every task has finished
+    template<typename Duration>
+    void wait_for(Duration d) {
+
+        std::unique_lock<std::mutex> lock(muter);
+
+        condition.wait_for(lock, d, [this] { return remaining() == 0; });
+    }
+
+    // read only after the count reached zero
+    std::exception_ptr exception() const { return error; }
+
+};
+
+class Pool_Batch {
+
+private:
+
+    std::shared_ptr<Pool_Latch> latch;
+
+    Thread_Pool_Core* pool;
+
+public:
+
+    // constructors
+    Pool_Batch() : pool(0) {}
+
+    Pool_Batch(const std::shared_ptr<Pool_Latch>& l, Thread_Pool_Core& p)
+
+        : latch(l)
+        , pool(&p) {}
+
+    // tasks not yet finished
+    size_t remaining() const { return latch ? latch->remaining() : 0; }
+
+    bool is_done() const { return remaining() == 0; }
+
+    // run pool tasks until every task of the batch has finished, then
+    // rethrow the first exception any of them threw
+    void wait_all() const {
+
+        if(!latch) { return; }
+
+        size_t misses = 0;
+
+        while(!is_done()) {
+
+            if(pool->work_front()) { misses = 0; continue; }
+
+            if(++misses < 16) { std::this_thread::yield(); }
+            else { latch->wait_for(std::chrono::microseconds(100)); }
+        }
+
+        if(latch->exception()) { std::rethrow_exception(latch->exception()); }
+    }
+
+};
+
+// run a callable of a batch and count the batch down
+template<typename F>
+struct Pool_Batch_Call {
+
+    std::shared_ptr<Pool_Latch> latch;
+
+    F f;
+
+    Pool_Batch_Call(const std::shared_ptr<Pool_Latch>& l, F&& f_in) : latch(l), f(std::move(f_in)) {}
+
+    void operator()() {
+
+        try { f(); }
+
+        catch(...) { latch->fail(std::current_exception()); }
+
+        latch->count_down();
+    }
+};
+
+// submit a copy of every callable in first .. last as one batch
+template<typename Iterator>
+Pool_Batch pool_batch(Thread_Pool_Core& core, Iterator first, Iterator last) {
+
+    typedef typename std::iterator_traits<Iterator>::value_type F;
+
+    size_t n = std::distance(first, last);
+
+    std::shared_ptr<Pool_Latch> latch = std::allocate_shared<Pool_Latch>(Pool_Allocator<Pool_Latch>(), n);
+
+    std::vector<Pool_Task*> tasks;
+
+    tasks.reserve(n);
+
+    try {
+
+        for(; first != last; ++first) { tasks.push_back(pool_task(Pool_Batch_Call<F>(latch, F(*first)))); }
+
+    } catch(...) {
+
+        for(size_t i = 0; i < tasks.size(); ++i) { delete tasks[i]; }
+
+        throw;
+    }
+
+    core.submit_batch(tasks.data(), n);
+
+    return Pool_Batch(latch, core);
+}
+
+// call f(begin, end) on chunks of grain indices of first .. last as one
+// batch, f is copied into every task. a grain of 0 makes about four
+// chunks per worker
+template<typename F>
+Pool_Batch pool_range(Thread_Pool_Core& core, size_t first, size_t last, size_t grain, F f) {
+
+    if(last <= first) { return Pool_Batch(); }
+
+    if(grain == 0) { grain = (last - first) / (4 * std::max<size_t>(core.size(), 1)) + 1; }
+
+    struct Chunk {
+
+        F f;
+
+        size_t begin, end;
+
+        void operator()() { f(begin, end); }
+    };
+
+    std::vector<Chunk> chunks;
+
+    chunks.reserve((last - first) / grain + 1);
+
+    for(size_t begin = first; begin < last; begin += grain) {
+
+        Chunk c = { f, begin, std::min(last, begin + grain) };
+
+        chunks.push_back(c);
+    }
+
+    return pool_batch(core, std::make_move_iterator(chunks.begin()), std::make_move_iterator(chunks.end()));
+}
+
+//*************************************************************************//
+
+#endif // THREAD_POOL_CORE_H_INCLUDED
@@ -0,0 +1,113 @@
+#ifndef TRANSPOSE_H_INCLUDED
+#define TRANSPOSE_H_INCLUDED
+
+//*************************************************************************//
+
+#include <algorithm>
+
+//*************************************************************************//
+//
+// cache-oblivious transposition
+//
+// the longer dimension is halved until a block fits comfortably in L1,
+// so reads and writes stay within a few cache lines at every level of
+// the memory hierarchy without knowing its sizes. row-major storage
+// with leading dimensions, as in Gemm.hpp.
+//
+//*************************************************************************//
+
+// blocks of at most this many elements are transposed directly
+const size_t transpose_leaf = 16 * 16;
+
+// B (columns x rows) = transpose of A (rows x columns)
+template<typename T>
+void transpose_block(size_t rows, size_t columns,
+                     const T* A, size_t lda,
+                     T* B, size_t ldb) {
+
+    if(rows * columns <= transpose_leaf) {
+
+        for(size_t i = 0; i < rows; ++i) {
+
+            for(size_t j = 0; j < columns; ++j) {
+
+                B[j * ldb + i] = A[i * lda + j];
+            }
+        }
+
+    } else if(rows >= columns) {
+
+        size_t h = rows / 2;
+
+        transpose_block(h, columns, A, lda, B, ldb);
+        transpose_block(rows - h, columns, A + h * lda, lda, B + h, ldb);
+
+    } else {
+
+        size_t h = columns / 2;
+
+        transpose_block(rows, h, A, lda, B, ldb);
+        transpose_block(rows, columns - h, A + h, lda, B + h * ldb, ldb);
+    }
+}
+
+// exchange X (rows x columns) with the transpose of Y (columns x rows)
+template<typename T>
+void transpose_swap(size_t rows, size_t columns,
+                    T* X, T* Y, size_t ld) {
+
+    if(rows * columns <= transpose_leaf) {
+
+        for(size_t i = 0; i < rows; ++i) {
+
+            for(size_t j = 0; j < columns; ++j) {
+
+                std::swap(X[i * ld + j], Y[j * ld + i]);
+            }
+        }
+
+    } else if(rows >= columns) {
+
+        size_t h = rows / 2;
+
+        transpose_swap(h, columns, X, Y, ld);
+        transpose_swap(rows - h, columns, X + h * ld, Y + h, ld);
+
+    } else {
+
+        size_t h = columns / 2;
+
+        transpose_swap(rows, h, X, Y, ld);
+        transpose_swap(rows, columns - h, X + h, Y + h * ld, ld);
+    }
+}
+
+// transpose the n x n block at A in place
+template<typename T>
+void transpose_square(size_t n, T* A, size_t lda) {
+
+    if(n * n <= transpose_leaf) {
+
+        for(size_t i = 0; i < n; ++i) {
+
+            for(size_t j = i + 1; j < n; ++j) {
+
+                std::swap(A[i * lda + j], A[j * lda + i]);
+            }
+        }
+
+        return;
+    }
+
+    size_t h = n / 2;
+
+    // diagonal blocks transpose onto themselves,
+    // the off-diagonal blocks exchange places
+    transpose_square(h, A, lda);
+    transpose_square(n - h, A + h * lda + h, lda);
+    transpose_swap(h, n - h, A + h, A + h * lda, lda);
+}
+
+//*************************************************************************//
+
+#endif // TRANSPOSE_H_INCLUDED
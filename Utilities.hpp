@@ -40,12 +40,6 @@ private:
     void assign(T& value,
                 std::uniform_real_distribution<T>&);
 
-    // round a complex value down
-    void round_down(std::complex<T>&);
-
-    // round a real value down
-    void round_down(T&);
-
 public:
     
     // basic constructors
@@ -73,16 +67,20 @@ public:
     void set_rounding_value(T);
 
     // fill matrix with random values
-    void randomize(Matrix<T>&, T, T);
+    template<typename A>
+    void randomize(Matrix<T, A>&, T, T);
 
     // round values close to zero to zero
-    void round_values(Matrix<T>&);
+    template<typename A>
+    void round_values(Matrix<T, A>&);
 
     // write data from a text file
-    void write_to_file(const Matrix<T>&, std::string);
+    template<typename A>
+    void write_to_file(const Matrix<T, A>&, std::string);
     
     // read data to a text file
-    void read_from_file(const Matrix<T>&, std::string);
+    template<typename A>
+    void read_from_file(Matrix<T, A>&, std::string);
 
 };
 
@@ -105,21 +103,6 @@ inline void Utilities<T>::assign(T& value,
     value = urd(dre);
 }
 
-// round a complex value down
-template<typename T>
-inline void Utilities<T>::round_down(std::complex<T>& value) {
-
-    if(value.real() > -rounding_value && value.real() < rounding_value) { value.real(0); }
-    if(value.imag() > -rounding_value && value.imag() < rounding_value) { value.imag(0); }
-}
-
-// round a real value down
-template<typename T>
-inline void Utilities<T>::round_down(T& value) {
-
-    if(value > -rounding_value && value < rounding_value) { value = 0; }
-}
-    
 //*************************************************************************//
 
 // constructors
@@ -153,7 +136,8 @@ void Utilities<T>::set_rounding_value(T new_rounding_value) {
 
 // fill T matrix with random values
 template<typename T>
-void Utilities<T>::randomize(Matrix<T>& M, T min, T max) {
+template<typename A>
+void Utilities<T>::randomize(Matrix<T, A>& M, T min, T max) {
 
     std::uniform_real_distribution<T> urd(min, max);
     
@@ -171,23 +155,22 @@ void Utilities<T>::randomize(Matrix<T>& M, T min, T max) {
 
 // round values close to zero to zero
 template<typename T>
-void Utilities<T>::round_values(Matrix<T>& M) {
+template<typename A>
+void Utilities<T>::round_values(Matrix<T, A>& M) {
     
-    size_t i_end = M.rows();
-    size_t j_end = M.columns();
+    T* a = M.data();
+    T r = rounding_value;
 
-    for(size_t i = 0; i != i_end; ++i) {
+    parallel_rows(M.rows() * M.columns(), 1, [a, r](size_t first, size_t last) {
 
-        for(size_t j = 0; j != j_end; ++j) {
-            
-            Utilities<T>::round_down(M(i, j));
-        }
-    }
+        simd_round_down(a + first, last - first, r);
+    });
 }
 
 // read data from a text file
 template<typename T>
-void Utilities<T>::write_to_file(const Matrix<T>& M,
+template<typename A>
+void Utilities<T>::write_to_file(const Matrix<T, A>& M,
                                  std::string file_name) {
     
     std::ofstream fout(file_name);
@@ -214,7 +197,8 @@ void Utilities<T>::write_to_file(const Matrix<T>& M,
 
 // write data to a text file
 template<typename T>
-void Utilities<T>::read_from_file(const Matrix<T>& M,
+template<typename A>
+void Utilities<T>::read_from_file(Matrix<T, A>& M,
                                   std::string file_name) {
     
     std::ifstream fin(file_name);
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "Utilities.hpp"
+#include "Timer.hpp"
+#include "Thread_Pool_G.hpp"
+#include "Batch_Gemm.hpp"
+
+template<typename T>
+struct multiply {
+
+    const Matrix<T>& M;
+    const Matrix<T>& N;
+
+    multiply(const Matrix<T>& M_in, const Matrix<T>& N_in)
+
+        : M(M_in)
+        , N(N_in) {}
+
+    Matrix<T> operator () () { return M * N; }
+
+};
+
+int main() {
+
+    // initialize objects
+    Utilities<double> Ut(std::pow(10, -14));
+    Timer<double> Ti;
+    Thread_Pool TP(2, 'f', 1);
+
+    size_t dims[] = { 16, 32, 64 };
+    size_t batches[] = { 20000, 5000, 1000 };
+
+    for(size_t d = 0; d < 3; ++d) {
+
+        size_t dim = dims[d];
+        size_t batch = batches[d];
+
+        // the batch as separate matrices
+        std::vector<Matrix<double>> M(batch, Matrix<double>(dim, dim));
+        std::vector<Matrix<double>> N(batch, Matrix<double>(dim, dim));
+
+        for(size_t b = 0; b < batch; ++b) {
+
+            Ut.randomize(M[b], -1.0, 1.0);
+            Ut.randomize(N[b], -1.0, 1.0);
+        }
+
+        // and back to back in contiguous arrays
+        std::vector<double> A(batch * dim * dim);
+        std::vector<double> B(batch * dim * dim);
+        std::vector<double> C(batch * dim * dim);
+
+        for(size_t b = 0; b < batch; ++b) {
+
+            std::copy(M[b].data(), M[b].data() + dim * dim, A.begin() + b * dim * dim);
+            std::copy(N[b].data(), N[b].data() + dim * dim, B.begin() + b * dim * dim);
+        }
+
+        // one pool task per product
+        std::vector<std::future<Matrix<double>>> Pf(batch);
+        std::vector<Matrix<double>> P(batch);
+
+        Ti.start();
+
+        for(size_t b = 0; b < batch; ++b) { Pf[b] = TP.load_back(multiply<double>(M[b], N[b])); }
+        for(size_t b = 0; b < batch; ++b) { P[b] = Pf[b].get(); }
+
+        Ti.stop();
+        double task_time = Ti.duration();
+
+        // one call for the whole batch
+        Ti.start();
+        batch_gemm(batch, dim, dim, dim, A.data(), B.data(), C.data(), TP);
+        Ti.stop();
+        double batch_time = Ti.duration();
+
+        // the interleaved kernels fuse multiply-adds, so compare to a tolerance
+        double difference = 0.0;
+
+        for(size_t b = 0; b < batch; ++b) {
+
+            for(size_t e = 0; e < dim * dim; ++e) {
+
+                difference = std::max(difference, std::abs(P[b].data()[e] - C[b * dim * dim + e]));
+            }
+        }
+
+        double flops = 2.0 * dim * dim * dim * batch / 1.0e9;
+
+        std::cout << "\n" << batch << " x " << dim << " x " << dim
+                  << "  per-matrix tasks: " << flops / task_time << " GFLOP/s"
+                  << "  batch_gemm: " << flops / batch_time << " GFLOP/s"
+                  << "  difference: " << difference;
+
+        // both batch paths on one thread, batch_gemm interleaves below
+        // batch_interleave_product multiply-adds
+        if(Batch_Interleaved<double>::lanes() != 0) {
+
+            Ti.start();
+            batch_interleaved_range(0, batch, dim, dim, dim, A.data(), B.data(), C.data());
+            Ti.stop();
+            double interleaved_time = Ti.duration();
+
+            double interleaved_difference = 0.0;
+
+            for(size_t b = 0; b < batch; ++b) {
+
+                for(size_t e = 0; e < dim * dim; ++e) {
+
+                    interleaved_difference = std::max(interleaved_difference,
+                                                      std::abs(P[b].data()[e] - C[b * dim * dim + e]));
+                }
+            }
+
+            Ti.start();
+
+            for(size_t b = 0; b < batch; ++b) {
+
+                size_t offset = b * dim * dim;
+
+                gemm(dim, dim, dim, A.data() + offset, dim, B.data() + offset, dim, C.data() + offset, dim, false);
+            }
+
+            Ti.stop();
+            double gemm_time = Ti.duration();
+
+            std::cout << "\n    one thread  interleaved: " << flops / interleaved_time << " GFLOP/s"
+                      << "  gemm: " << flops / gemm_time << " GFLOP/s"
+                      << "  difference: " << interleaved_difference;
+        }
+    }
+
+    std::cout << "\n" << std::endl;
+
+    return 0;
+}
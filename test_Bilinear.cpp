@@ -0,0 +1,111 @@
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "Matrix.hpp"
+#include "Utilities.hpp"
+#include "Timer.hpp"
+#include "Thread_Pool_T.hpp"
+#include "Bilinear.hpp"
+
+// largest difference between two products
+double max_error(const Matrix<double>& A, const Matrix<double>& B) {
+
+    double error = 0.0;
+
+    for(size_t i = 0; i < A.rows(); ++i) {
+
+        for(size_t j = 0; j < A.columns(); ++j) {
+
+            error = std::max(error, std::fabs(A(i, j) - B(i, j)));
+        }
+    }
+
+    return error;
+}
+
+int main() {
+
+    using namespace std;
+
+    // initialize objects
+    Utilities<double> Ut(std::pow(10, -14));
+    Timer<double> Ti;
+    Thread_Pool<Matrix<double>> TP(4, 'f', 1);
+
+    const char* names[] = { "strassen <2,2,2;7>", "laderman <3,3,3;23>",
+                            "strassen^2 <4,4,4;49>", "strassen x classical <2,4,2;14>",
+                            "hopcroft-kerr <2,3,3;15>", "transposed <3,3,2;15>" };
+
+    Bilinear_Scheme schemes[] = {
+
+        bilinear_strassen(),
+        bilinear_laderman(),
+        bilinear_product(bilinear_strassen(), bilinear_strassen()),
+        bilinear_product(bilinear_strassen(), bilinear_classical(1, 2, 1)),
+        bilinear_hopcroft_kerr(),
+        bilinear_transpose(bilinear_hopcroft_kerr())
+    };
+
+    const size_t count = sizeof(schemes) / sizeof(schemes[0]);
+
+    // failed schemes and products further from gemm than the tolerance
+    size_t wrong = 0;
+    const double tolerance = 1e-8;
+
+    for(size_t s = 0; s < count; ++s) {
+
+        bool verified = schemes[s].verify();
+
+        cout << "\n" << names[s] << " verified: " << verified;
+
+        if(!verified) { ++wrong; }
+    }
+
+    cout << "\n";
+
+    // sizes divisible by every block shape above
+    size_t sizes[] = { 576, 1152, 2304 };
+
+    for(size_t d = 0; d < 3; ++d) {
+
+        size_t dim = sizes[d];
+
+        Matrix<double> A(dim, dim);
+        Matrix<double> B(dim, dim);
+
+        Ut.randomize(A, -1.0, 1.0);
+        Ut.randomize(B, -1.0, 1.0);
+
+        Ti.start();
+        Matrix<double> G = A * B;
+        Ti.stop();
+        cout << "\n" << dim << " x " << dim << " gemm: " << Ti.duration();
+
+        for(size_t s = 0; s < count; ++s) {
+
+            Ti.start();
+            Matrix<double> C = Bilinear<double>(A, B, schemes[s], 1)();
+            Ti.stop();
+            double serial = Ti.duration();
+
+            Ti.start();
+            Matrix<double> P = Parallel_Bilinear<double>(A, B, schemes[s], 1, 0, TP)();
+            Ti.stop();
+
+            double error = std::max(max_error(C, G), max_error(P, G));
+
+            cout << "\n    " << names[s] << ": " << serial
+                 << "  parallel: " << Ti.duration()
+                 << "  max error: " << error;
+
+            if(!(error <= tolerance)) { ++wrong; }
+        }
+
+        cout << "\n";
+    }
+
+    cout << "\nfailed schemes and products: " << wrong << endl;
+
+    return wrong != 0;
+}
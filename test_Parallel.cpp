@@ -0,0 +1,191 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Matrix.hpp"
+#include "Utilities.hpp"
+#include "Timer.hpp"
+#include "Thread_Pool_G.hpp"
+
+int main() {
+
+    using namespace std;
+
+    // initialize objects
+    Utilities<double> Ut(std::pow(10, -14));
+    Timer<double> Ti;
+
+    // every index visited once, sums exact, exceptions rethrown
+    size_t wrong = 0;
+
+    for(size_t threads = 1; threads <= 8; threads *= 2) {
+
+        Thread_Pool TP(threads, 'f', 1);
+
+        size_t sizes[] = { 1, 7, 1000, 100003 };
+
+        for(size_t s = 0; s < 4; ++s) {
+
+            size_t n = sizes[s];
+
+            std::vector<std::atomic<int>> visits(n);
+
+            for(size_t i = 0; i < n; ++i) { visits[i] = 0; }
+
+            TP.parallel_for(0, n, 0, [&visits](size_t first, size_t last) {
+
+                for(size_t i = first; i < last; ++i) { visits[i].fetch_add(1); }
+            });
+
+            Parallel_Affinity affinity;
+
+            for(size_t round = 0; round < 3; ++round) {
+
+                TP.parallel_for(0, n, 16, [&visits](size_t first, size_t last) {
+
+                    for(size_t i = first; i < last; ++i) { visits[i].fetch_add(1); }
+
+                }, affinity);
+            }
+
+            for(size_t i = 0; i < n; ++i) { wrong += visits[i].load() != 4; }
+
+            // a grain of 0 allows pieces of one index
+            Parallel_Affinity single;
+
+            TP.parallel_for(0, n, 0, [](size_t, size_t) {}, single);
+
+            wrong += single.owners.size() != std::min(4 * (threads + 1), n);
+
+            size_t sum = TP.parallel_reduce(0, n, 3, size_t(0),
+                                            [](size_t first, size_t last, size_t init) {
+
+                for(size_t i = first; i < last; ++i) { init += i; }
+
+                return init;
+
+            }, [](size_t a, size_t b) { return a + b; });
+
+            wrong += sum != n * (n - 1) / 2;
+        }
+
+        bool caught = false;
+
+        try {
+
+            TP.parallel_for(0, 1000, 1, [](size_t first, size_t) {
+
+                if(first == 500) { throw std::runtime_error("piece failed"); }
+            });
+
+        } catch(std::runtime_error&) { caught = true; }
+
+        wrong += !caught;
+    }
+
+    cout << "\nincorrect results: " << wrong << "\n";
+
+    // dot product over the pool against a plain loop
+    size_t n = size_t(1) << 24;
+
+    std::vector<double> x(n, 0.5);
+    std::vector<double> y(n, 2.0);
+
+    Ti.start();
+
+    double serial = 0.0;
+
+    for(size_t i = 0; i < n; ++i) { serial += x[i] * y[i]; }
+
+    Ti.stop();
+
+    cout << "\ndot product of " << n << " elements, loop: " << Ti.duration();
+
+    auto dot = [&x, &y](size_t first, size_t last, double init) {
+
+        for(size_t i = first; i < last; ++i) { init += x[i] * y[i]; }
+
+        return init;
+    };
+
+    auto plus = [](double a, double b) { return a + b; };
+
+    for(size_t threads = 1; threads <= 16; threads *= 4) {
+
+        Thread_Pool TP(threads, 'f', 1);
+
+        Ti.start();
+        double parallel = TP.parallel_reduce(0, n, 0, 0.0, dot, plus);
+        Ti.stop();
+
+        cout << "\n" << threads << " threads  parallel_reduce: " << Ti.duration()
+             << "  difference: " << parallel - serial;
+    }
+
+    cout << "\n";
+
+    // repeated sweeps over a cache sized array, affinity sends every
+    // piece back to the worker that holds it
+    {
+        Thread_Pool TP(4, 'f', 1);
+
+        std::vector<double> z(size_t(1) << 18, 1.0);
+
+        auto sweep = [&z](size_t first, size_t last) {
+
+            for(size_t i = first; i < last; ++i) { z[i] = z[i] * 0.999 + 0.001; }
+        };
+
+        size_t sweeps = 200;
+
+        Ti.start();
+
+        for(size_t k = 0; k < sweeps; ++k) { TP.parallel_for(0, z.size(), 0, sweep); }
+
+        Ti.stop();
+        double automatic = Ti.duration();
+
+        Parallel_Affinity affinity;
+
+        Ti.start();
+
+        for(size_t k = 0; k < sweeps; ++k) { TP.parallel_for(0, z.size(), 1024, sweep, affinity); }
+
+        Ti.stop();
+
+        cout << "\n" << sweeps << " sweeps over " << z.size() << " elements, auto: " << automatic
+             << "  affinity: " << Ti.duration();
+    }
+
+    // element-wise matrix operations, on the shared pool past the threshold
+    {
+        size_t dim = 2048;
+
+        Matrix<double> A(dim, dim);
+        Matrix<double> B(dim, dim);
+
+        Ut.randomize(A, -1.0, 1.0);
+        Ut.randomize(B, -1.0, 1.0);
+
+        Ti.start();
+        A += B;
+        Ti.stop();
+        cout << "\n\n" << dim << " x " << dim << " with " << parallel_workers()
+             << " shared workers  +=: " << Ti.duration();
+
+        Ti.start();
+        Matrix<double> C = A + B - B;
+        Ti.stop();
+        cout << "  A + B - B: " << Ti.duration();
+
+        Ti.start();
+        Ut.round_values(C);
+        Ti.stop();
+        cout << "  round_values: " << Ti.duration();
+    }
+
+    cout << "\n" << endl;
+
+    return wrong != 0;
+}
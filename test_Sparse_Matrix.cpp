@@ -0,0 +1,104 @@
+#include <iostream>
+#include <random>
+
+#include "Matrix.hpp"
+#include "Utilities.hpp"
+#include "Timer.hpp"
+#include "Thread_Pool_G.hpp"
+#include "Sparse_Matrix.hpp"
+
+// the density from which the dense product is faster, 0 if it never was
+void print_crossover(const char* product, double density) {
+
+    std::cout << "\ndense " << product << " wins ";
+
+    if(density == 0.0) { std::cout << "never"; }
+    else { std::cout << "from density " << density; }
+}
+
+int main() {
+
+    // initialize objects
+    Utilities<double> Ut(std::pow(10, -14));
+    Utilities<double> Uc(std::pow(10, -10));
+    Timer<double> Ti;
+    Thread_Pool TP(2, 'f', 1);
+
+    std::mt19937 generator(2015);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    size_t dim = 2000;
+    size_t width = 256;
+
+    // a vector and a block of vectors
+    Matrix<double> x(dim, 1);
+    Matrix<double> X(dim, width);
+
+    Ut.randomize(x, -1.0, 1.0);
+    Ut.randomize(X, -1.0, 1.0);
+
+    double densities[] = { 0.001, 0.01, 0.05, 0.1, 0.2, 0.3, 0.5 };
+
+    double spmv_crossover = 0.0;
+    double spmm_crossover = 0.0;
+
+    for(size_t d = 0; d < 7; ++d) {
+
+        double density = densities[d];
+
+        Matrix<double> A(dim, dim);
+
+        for(size_t i = 0; i < dim; ++i) {
+
+            for(size_t j = 0; j < dim; ++j) {
+
+                if(uniform(generator) < density) { A(i, j) = uniform(generator) - 0.5; }
+            }
+        }
+
+        Sparse_Matrix<double> S(A);
+
+        // matrix-vector products
+        Ti.start();
+        for(size_t i = 0; i < 10; ++i) { Matrix<double> y = A * x; }
+        Ti.stop();
+        double dense_mv = Ti.duration();
+
+        Ti.start();
+        for(size_t i = 0; i < 10; ++i) { Matrix<double> y = S.multiply(x, TP); }
+        Ti.stop();
+        double sparse_mv = Ti.duration();
+
+        // matrix-matrix products
+        Ti.start();
+        Matrix<double> Y = A * X;
+        Ti.stop();
+        double dense_mm = Ti.duration();
+
+        Ti.start();
+        Matrix<double> Z = S.multiply(X, TP);
+        Ti.stop();
+        double sparse_mm = Ti.duration();
+
+        if(spmv_crossover == 0.0 && dense_mv < sparse_mv) { spmv_crossover = density; }
+        if(spmm_crossover == 0.0 && dense_mm < sparse_mm) { spmm_crossover = density; }
+
+        // summation order differs from gemm, so compare to a tolerance
+        Z -= Y;
+        Uc.round_values(Z);
+
+        std::cout << "\ndensity " << density
+                  << "  SpMV: " << sparse_mv << " (dense " << dense_mv << ")"
+                  << "  SpMM: " << sparse_mm << " (dense " << dense_mm << ")"
+                  << "  matches: " << (Z == Matrix<double>(dim, width));
+    }
+
+    std::cout << "\n";
+
+    print_crossover("SpMV", spmv_crossover);
+    print_crossover("SpMM", spmm_crossover);
+
+    std::cout << "\n" << std::endl;
+
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 #include "Matrix.hpp"
 #include "Utilities.hpp"
@@ -6,6 +8,55 @@
 #include "Thread_Pool_T.hpp"
 #include "Strassen.hpp"
 
+// the original ikj product, kept as a baseline for the blocked gemm
+template<typename T>
+Matrix<T> ikj_product(const Matrix<T>& A, const Matrix<T>& B) {
+
+    size_t i_end = A.rows();
+    size_t k_end = A.columns();
+    size_t j_end = B.columns();
+
+    Matrix<T> C(i_end, j_end);
+
+    for(size_t i = 0; i < i_end; ++i) {
+
+        for(size_t k = 0; k < k_end; ++k) {
+
+            T a = A(i, k);
+
+            for(size_t j = 0; j < j_end; ++j) {
+
+                C(i, j) += a * B(k, j);
+            }
+        }
+    }
+
+    return C;
+}
+
+// billions of floating point operations per second for an n^3 product
+double gflops(size_t n, double seconds) {
+
+    return 2.0 * n * n * n / seconds / 1.0e9;
+}
+
+// largest element-wise difference between two products of the same shape
+template<typename T>
+T max_error(const Matrix<T>& G, const Matrix<T>& S) {
+
+    T error = T(0);
+
+    for(size_t i = 0; i < G.rows(); ++i) {
+
+        for(size_t j = 0; j < G.columns(); ++j) {
+
+            error = std::max(error, std::fabs(G(i, j) - S(i, j)));
+        }
+    }
+
+    return error;
+}
+
 int main() {
 
 	using namespace std;
@@ -15,6 +66,52 @@ int main() {
     Timer<double> Ti;
 	Thread_Pool<Matrix<double>> TP(4, 'f', 2);
 
+    // compare the blocked gemm against the ikj loop
+    for(size_t dim = 256; dim <= 1024; dim *= 2) {
+
+        Matrix<double> A(dim, dim);
+        Matrix<double> B(dim, dim);
+
+        Ut.randomize(A, -1.0, 1.0);
+        Ut.randomize(B, -1.0, 1.0);
+
+        Ti.start();
+        Matrix<double> C = ikj_product(A, B);
+        Ti.stop();
+        double ikj_time = Ti.duration();
+
+        Ti.start();
+        Matrix<double> D = A * B;
+        Ti.stop();
+        double gemm_time = Ti.duration();
+
+        cout << "\n" << dim << " x " << dim
+             << "  ikj: " << gflops(dim, ikj_time) << " GFLOP/s"
+             << "  gemm: " << gflops(dim, gemm_time) << " GFLOP/s";
+    }
+
+    cout << "\n";
+
+    // A^T * B through an explicit transpose against the transposed gemm flag
+    {
+        Matrix<double> A(1024, 1024);
+        Matrix<double> B(1024, 1024);
+
+        Ut.randomize(A, -1.0, 1.0);
+        Ut.randomize(B, -1.0, 1.0);
+
+        Ti.start();
+        Matrix<double> AT = A.transpose();
+        Ti.stop();
+        cout << "\n1024 x 1024 transpose duration: " << Ti.duration();
+
+        Ti.start();
+        Matrix<double> C = product(A, B, 't', 'n');
+        Ti.stop();
+        cout << "\nA^T * B: " << gflops(1024, Ti.duration()) << " GFLOP/s"
+             << "  matches: " << (C == AT * B) << "\n";
+    }
+
 	size_t dim = 2048;
 
 	Matrix<double> M(dim, dim);
@@ -23,10 +120,135 @@ int main() {
     Ut.randomize(M, -1.0, 1.0);
     Ut.randomize(N, -1.0, 1.0);
 
+    // element-wise passes use the SIMD level detected at startup
+    const char* levels[] = { "scalar", "sse2", "avx2", "avx512" };
+
+    Ti.start();
+    for(size_t i = 0; i < 10; ++i) { M += N; M -= N; }
+    Ut.round_values(M);
+    Ti.stop();
+    cout << "\nelement-wise duration (" << levels[simd_level()] << "): "
+         << Ti.duration() << endl;
+
+    Ti.start();
+    Matrix<double> Q = M * N;
+    Ti.stop();
+    cout << "\ngemm duration: " << Ti.duration()
+         << " (" << gflops(dim, Ti.duration()) << " GFLOP/s)" << endl;
+
+    // Strassen into preallocated storage with one workspace
+    Matrix<double> W(dim, dim, uninitialized);
+    Workspace_Strassen<double> WS(dim, 2);
+
+    Ti.start();
+    WS(M, N, W);
+    Ti.stop();
+    cout << "\nworkspace Strassen duration: " << Ti.duration()
+         << " (workspace " << WS.peak_bytes() / (1024 * 1024) << " MiB"
+         << ", max error " << max_error(Q, W) << ")" << endl;
+
+    // the Winograd variant, fewer additions and fused combination passes
+    Workspace_Winograd<double> WW(dim, 2);
+
+    Ti.start();
+    WW(M, N, W);
+    Ti.stop();
+    cout << "\nworkspace Winograd duration: " << Ti.duration()
+         << " (workspace " << WW.peak_bytes() / (1024 * 1024) << " MiB"
+         << ", max error " << max_error(Q, W) << ")" << endl;
+
+    // the same product under a scratch budget, fewer branches or levels when tight
+    for(size_t budget = 16; budget <= 64; budget *= 2) {
+
+        Capped_Strassen<double> CS(dim, dim, dim, 2, budget * 1024 * 1024, 4, TP);
+
+        Ti.start();
+        CS(M, N, W);
+        Ti.stop();
+        cout << "\ncapped Strassen duration, " << budget << " MiB budget: " << Ti.duration()
+             << " (r " << CS.r << ", branches " << CS.branches
+             << ", used " << CS.peak_bytes() / (1024 * 1024) << " MiB"
+             << ", max error " << max_error(Q, W) << ")" << endl;
+    }
+
+    // odd and rectangular shapes peel their edges instead of padding
+    {
+        Matrix<double> A(dim - 1, dim / 2 + 1);
+        Matrix<double> B(dim / 2 + 1, dim - 3);
+
+        Ut.randomize(A, -1.0, 1.0);
+        Ut.randomize(B, -1.0, 1.0);
+
+        Ti.start();
+        Matrix<double> G = A * B;
+        Ti.stop();
+        cout << "\nrectangular gemm duration: " << Ti.duration() << endl;
+
+        Ti.start();
+        Matrix<double> S = Strassen<double>(A, B, 2)();
+        Ti.stop();
+
+        cout << "\nrectangular Strassen duration: " << Ti.duration()
+             << " (max error " << max_error(G, S) << ")" << endl;
+    }
+
+    // the same product on huge page backed storage
+    Matrix<double, Huge_Page_Allocator<double>> MH = M;
+    Matrix<double, Huge_Page_Allocator<double>> NH = N;
+
+    Ti.start();
+    Matrix<double, Huge_Page_Allocator<double>> QH = MH * NH;
+    Ti.stop();
+    cout << "\nhuge page gemm duration: " << Ti.duration()
+         << " (" << gflops(dim, Ti.duration()) << " GFLOP/s)" << endl;
+
     Ti.start();
     Matrix<double> P = Parallel_Strassen<double>(M, N, 5, 0, TP)();
 	Ti.stop();
-    cout << "\nparallel duration: " << Ti.duration() << "\n" << endl;
+    cout << "\nparallel duration: " << Ti.duration() << endl;
+
+    // depths chosen from the machine profile, calibrated on first run
+    Strassen_Profile profile;
+
+    if(!profile.load(strassen_profile_path())) {
+
+        Ti.start();
+        profile = strassen_calibrate<double>();
+        Ti.stop();
+        cout << "\ncalibration duration: " << Ti.duration() << endl;
+    }
+
+    strassen_profile() = profile;
+
+    Parallel_Strassen<double> PA(M, N, TP);
+
+    size_t r = PA.r;
+    size_t p = PA.p;
+
+    Ti.start();
+    Matrix<double> PP = PA();
+    Ti.stop();
+    cout << "\nprofiled parallel duration: " << Ti.duration()
+         << " (crossover " << profile.crossover << ", r " << r
+         << ", p " << p << ")" << endl;
+
+    // the same depths as a task graph, no worker waits on a product
+    Graph_Strassen<double> GA(M, N, TP);
+
+    r = GA.r;
+    p = GA.p;
+
+    Ti.start();
+    Matrix<double> PG = GA();
+    Ti.stop();
+    cout << "\ntask graph duration: " << Ti.duration()
+         << " (r " << r << ", p " << p << ", max error " << max_error(Q, PG) << ")" << endl;
+
+    Ti.start();
+    Matrix<double> PW = Parallel_Winograd<double>(M, N, 5, 0, TP)();
+    Ti.stop();
+    cout << "\nparallel Winograd duration: " << Ti.duration()
+         << " (max error " << max_error(Q, PW) << ")\n" << endl;
 
     return 0;
 }
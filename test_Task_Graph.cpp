@@ -0,0 +1,241 @@
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "Matrix.hpp"
+#include "Utilities.hpp"
+#include "Algebra.hpp"
+#include "Timer.hpp"
+#include "Thread_Pool_G.hpp"
+
+int main() {
+
+    using namespace std;
+
+    // initialize objects
+    Timer<double> Ti;
+    Thread_Pool TP(4, 'f', 1);
+
+    size_t wrong = 0;
+
+    // a diamond with results passed along the edges, run three times
+    {
+        Task_Graph G;
+
+        int seed = 1;
+
+        Task_Node<int> a = G.add([&seed] { return seed; });
+        Task_Node<int> b = a.then([](int x) { return x + 1; });
+        Task_Node<int> c = a.then([](int x) { return x * 10; });
+
+        Task_Node<int> d = G.add([b, c] { return b.get() + c.get(); });
+
+        d.after(b).after(c);
+
+        for(seed = 1; seed <= 3; ++seed) {
+
+            TP.run(G).wait_all();
+
+            wrong += d.get() != (seed + 1) + seed * 10;
+        }
+
+        // an exception skips the rest of the run and a later run recovers
+        Task_Node<void> e = d.then([&seed](int) { if(seed == 0) { throw std::runtime_error("node failed"); } });
+
+        std::atomic<int> after_e(0);
+
+        e.then([&after_e] { after_e.fetch_add(1); });
+
+        bool caught = false;
+
+        seed = 0;
+
+        try { TP.run(G).wait_all(); } catch(std::runtime_error&) { caught = true; }
+
+        wrong += !caught || after_e.load() != 0;
+
+        seed = 5;
+
+        TP.run(G).wait_all();
+
+        wrong += d.get() != 56 || after_e.load() != 1;
+
+        // a cycle is refused before anything runs
+        a.after(d);
+
+        caught = false;
+
+        try { TP.run(G); } catch(std::logic_error&) { caught = true; }
+
+        wrong += !caught;
+    }
+
+    // graphs that go out of scope as soon as their run has finished
+    for(size_t round = 0; round < 1000; ++round) {
+
+        Task_Graph G;
+
+        std::atomic<int> leaves(0);
+
+        Task_Node<void> root = G.add([] {});
+
+        for(size_t i = 0; i < 4; ++i) { root.then([&leaves] { leaves.fetch_add(1); }); }
+
+        TP.run(G).wait_all();
+
+        wrong += leaves.load() != 4;
+    }
+
+    cout << "\nincorrect results: " << wrong << "\n";
+
+    // randomize -> multiply -> inverse -> round, four pipelines side by side
+    size_t dim = 200;
+    size_t iterations = 10;
+
+    std::vector<Matrix<double>> inputs(4, Matrix<double>(dim, dim));
+
+    auto pipeline = [&inputs](Task_Graph& G, size_t k) {
+
+        // Utilities and Algebra keep state, so every node makes its own
+        Task_Node<Matrix<double>> random = G.add([&inputs, k] {
+
+            Utilities<double> U;
+
+            U.randomize(inputs[k], -1.0, 1.0);
+
+            return inputs[k];
+        });
+
+        return random.then([](const Matrix<double>& M) { return M * M; })
+                     .then([](const Matrix<double>& M) { Algebra Al; return Al.inverse(M); })
+                     .then([](const Matrix<double>& M) {
+
+                         Utilities<double> U(std::pow(10, -10));
+
+                         Matrix<double> R = M;
+
+                         U.round_values(R);
+
+                         return R;
+                     });
+    };
+
+    // the same pipelines with a blocking get at every edge
+    Ti.start();
+
+    for(size_t i = 0; i < iterations; ++i) {
+
+        std::vector<std::future<Matrix<double>>> stage(4);
+
+        for(size_t k = 0; k < 4; ++k) {
+
+            stage[k] = TP.load_back([&inputs, k] {
+
+                Utilities<double> U;
+
+                U.randomize(inputs[k], -1.0, 1.0);
+
+                return inputs[k];
+            });
+        }
+
+        for(size_t k = 0; k < 4; ++k) {
+
+            Matrix<double> M = stage[k].get();
+
+            stage[k] = TP.load_back([M] { return M * M; });
+        }
+
+        for(size_t k = 0; k < 4; ++k) {
+
+            Matrix<double> M = stage[k].get();
+
+            stage[k] = TP.load_back([M] { Algebra Al; return Al.inverse(M); });
+        }
+
+        for(size_t k = 0; k < 4; ++k) {
+
+            Matrix<double> M = stage[k].get();
+
+            stage[k] = TP.load_back([M] {
+
+                Utilities<double> U(std::pow(10, -10));
+
+                Matrix<double> R = M;
+
+                U.round_values(R);
+
+                return R;
+            });
+        }
+
+        for(size_t k = 0; k < 4; ++k) { stage[k].get(); }
+    }
+
+    Ti.stop();
+    double futures = Ti.duration();
+
+    Task_Graph G;
+
+    std::vector<Task_Node<Matrix<double>>> outputs;
+
+    for(size_t k = 0; k < 4; ++k) { outputs.push_back(pipeline(G, k)); }
+
+    Ti.start();
+
+    for(size_t i = 0; i < iterations; ++i) { TP.run(G).wait_all(); }
+
+    Ti.stop();
+
+    cout << "\n" << iterations << " runs of 4 pipelines on " << dim << " x " << dim
+         << "  futures: " << futures << "  reused graph: " << Ti.duration()
+         << "  rows: " << outputs[0].get().rows();
+
+    // cost of running a graph of small nodes, rebuilt or reused
+    size_t nodes = 1000;
+    size_t runs = 200;
+
+    std::atomic<size_t> count(0);
+
+    auto build = [&count, nodes](Task_Graph& H) {
+
+        // a fan of chains of ten
+        for(size_t c = 0; c < nodes / 10; ++c) {
+
+            Task_Node<void> n = H.add([&count] { count.fetch_add(1); });
+
+            for(size_t l = 1; l < 10; ++l) { n = n.then([&count] { count.fetch_add(1); }); }
+        }
+    };
+
+    Ti.start();
+
+    for(size_t r = 0; r < runs; ++r) {
+
+        Task_Graph H;
+
+        build(H);
+
+        TP.run(H).wait_all();
+    }
+
+    Ti.stop();
+    double rebuilt = Ti.duration();
+
+    Task_Graph H;
+
+    build(H);
+
+    Ti.start();
+
+    for(size_t r = 0; r < runs; ++r) { TP.run(H).wait_all(); }
+
+    Ti.stop();
+
+    cout << "\n" << runs << " runs of " << nodes << " small nodes  rebuilt: " << rebuilt
+         << "  reused: " << Ti.duration() << "  nodes run: " << count.load();
+
+    cout << "\n" << endl;
+
+    return wrong != 0;
+}
@@ -0,0 +1,390 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <ctime>
+#include <cstdlib>
+#include <new>
+
+#include "Timer.hpp"
+#include "Thread_Pool_G.hpp"
+
+// heap allocations made by the whole program, the replacements are kept
+// out of line so the compiler does not pair malloc with a new expression
+#if defined(__GNUC__) || defined(__clang__)
+#define TEST_NOINLINE __attribute__((noinline))
+#else
+#define TEST_NOINLINE
+#endif
+
+std::atomic<size_t> allocations(0);
+
+TEST_NOINLINE void* operator new(size_t size) {
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if(void* p = std::malloc(size ? size : 1)) { return p; }
+
+    throw std::bad_alloc();
+}
+
+TEST_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+
+TEST_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// spawn 4^depth leaf tasks by recursive fork-join, each level waits for
+// its children by running pool tasks
+void fork_join(Thread_Pool& TP, size_t depth, std::atomic<size_t>& parent) {
+
+    if(depth == 0) { parent.fetch_sub(1); return; }
+
+    std::atomic<size_t> pending(4);
+
+    for(size_t i = 0; i < 4; ++i) {
+
+        TP.load_front([&TP, depth, &pending] { fork_join(TP, depth - 1, pending); });
+    }
+
+    while(pending.load() != 0) {
+
+        if(!TP.work_front()) { std::this_thread::yield(); }
+    }
+
+    parent.fetch_sub(1);
+}
+
+// std::deque behind a mutex, the injection queue before it was lock-free
+struct Locked_Queue {
+
+    std::deque<Pool_Task*> tasks;
+
+    std::mutex muter;
+
+    bool push(Pool_Task* task) {
+
+        std::lock_guard<std::mutex> lock(muter);
+
+        tasks.push_back(task);
+
+        return true;
+    }
+
+    Pool_Task* pop() {
+
+        std::lock_guard<std::mutex> lock(muter);
+
+        if(tasks.empty()) { return 0; }
+
+        Pool_Task* task = tasks.front();
+
+        tasks.pop_front();
+
+        return task;
+    }
+};
+
+// millions of items per second through a queue, producers push while
+// one consumer pops, a full queue makes the producer yield
+template<typename Queue>
+double contention(Queue& queue, size_t producers, size_t items, Pool_Task* task) {
+
+    Timer<double> Ti;
+
+    std::vector<std::thread> threads;
+
+    size_t each = items / producers;
+
+    Ti.start();
+
+    for(size_t p = 0; p < producers; ++p) {
+
+        threads.push_back(std::thread([&queue, each, task] {
+
+            for(size_t i = 0; i < each; ++i) {
+
+                while(!queue.push(task)) { std::this_thread::yield(); }
+            }
+        }));
+    }
+
+    for(size_t popped = 0; popped < each * producers; ) {
+
+        if(queue.pop()) { ++popped; }
+        else { std::this_thread::yield(); }
+    }
+
+    Ti.stop();
+
+    for(size_t p = 0; p < producers; ++p) { threads[p].join(); }
+
+    return each * producers / Ti.duration() / 1.0e6;
+}
+
+// sum of first .. last - 1 by recursive halving, every level waits on
+// a pool future, which runs other tasks instead of blocking the worker
+size_t nested_sum(Thread_Pool& TP, size_t first, size_t last) {
+
+    if(last - first <= 64) {
+
+        size_t sum = 0;
+
+        for(size_t i = first; i < last; ++i) { sum += i; }
+
+        return sum;
+    }
+
+    size_t middle = first + (last - first) / 2;
+
+    Pool_Future<size_t> left = TP.submit([&TP, first, middle] { return nested_sum(TP, first, middle); });
+
+    size_t right = nested_sum(TP, middle, last);
+
+    return left.get() + right;
+}
+
+int main() {
+
+    using namespace std;
+
+    // initialize objects
+    Timer<double> Ti;
+
+    size_t tasks = 200000;
+    size_t depth = 8;
+
+    cout << "\ntask throughput in millions of tasks per second\n";
+
+    for(size_t threads = 1; threads <= 64; threads *= 2) {
+
+        Thread_Pool TP(threads, 'f', 1);
+
+        // tasks submitted from outside the pool
+        std::atomic<size_t> count(0);
+
+        Ti.start();
+
+        for(size_t i = 0; i < tasks; ++i) { TP.load_back([&count] { count.fetch_add(1); }); }
+
+        while(count.load() != tasks) {
+
+            if(!TP.work_front()) { std::this_thread::yield(); }
+        }
+
+        Ti.stop();
+        double external = tasks / Ti.duration() / 1.0e6;
+
+        // tasks spawned by workers onto their own deques and stolen
+        std::atomic<size_t> root(1);
+
+        Ti.start();
+
+        TP.load_back([&TP, depth, &root] { fork_join(TP, depth, root); });
+
+        while(root.load() != 0) {
+
+            if(!TP.work_front()) { std::this_thread::yield(); }
+        }
+
+        Ti.stop();
+
+        // internal nodes and leaves
+        double spawned = 0.0;
+
+        for(size_t d = 0, n = 1; d <= depth; ++d, n *= 4) { spawned += n; }
+
+        cout << "\n" << threads << " threads  external: " << external
+             << "  fork-join: " << spawned / Ti.duration() / 1.0e6;
+    }
+
+    cout << "\n";
+
+    // nested fork-join where every worker waits, plain futures would deadlock
+    {
+        Thread_Pool TP(2, 'f', 1);
+
+        size_t n = 1 << 22;
+
+        Ti.start();
+        size_t sum = TP.submit([&TP, n] { return nested_sum(TP, 0, n); }).get();
+        Ti.stop();
+
+        cout << "\nnested fork-join over " << n / 64 << " leaves: " << Ti.duration()
+             << "  correct: " << (sum == n * (n - 1) / 2);
+    }
+
+    // heap allocations per submitted task once the block cache is warm
+    {
+        Thread_Pool TP(2, 'f', 1);
+
+        size_t n = 100000;
+
+        std::atomic<size_t> count(0);
+
+        double padding[64] = {};
+
+        for(size_t round = 0; round < 2; ++round) {
+
+            size_t before = allocations.load();
+
+            for(size_t i = 0; i < n; ++i) { TP.load_back([&count] { count.fetch_add(1); }); }
+
+            while(count.load() != n) { TP.work_front(); }
+
+            size_t small = allocations.load() - before;
+
+            count = 0;
+
+            before = allocations.load();
+
+            for(size_t i = 0; i < n; ++i) { TP.load_back([&count, padding] { count.fetch_add(1 + size_t(padding[0])); }); }
+
+            while(count.load() != n) { TP.work_front(); }
+
+            size_t large = allocations.load() - before;
+
+            count = 0;
+
+            if(round == 1) {
+
+                cout << "\nheap allocations per task, small callable: " << double(small) / n
+                     << "  512 byte callable: " << double(large) / n;
+            }
+        }
+    }
+
+    // fan out of small row blocks, a future each against one batch
+    cout << "\n\nfan out in millions of tasks per second\n";
+
+    for(size_t threads = 1; threads <= 16; threads *= 4) {
+
+        Thread_Pool TP(threads, 'f', 1);
+
+        size_t blocks = 20000;
+
+        std::vector<double> rows(blocks * 16, 1.0);
+
+        // scale 16 rows per task
+        auto scale = [&rows](size_t first, size_t last) {
+
+            for(size_t i = 16 * first; i < 16 * last; ++i) { rows[i] *= 1.0001; }
+        };
+
+        std::vector<std::future<void>> futures;
+
+        futures.reserve(blocks);
+
+        Ti.start();
+
+        for(size_t b = 0; b < blocks; ++b) { futures.push_back(TP.load_back([scale, b] { scale(b, b + 1); })); }
+
+        for(size_t b = 0; b < blocks; ++b) { futures[b].get(); }
+
+        Ti.stop();
+        double one_each = blocks / Ti.duration() / 1.0e6;
+
+        Ti.start();
+        TP.load_range(0, blocks, 1, scale).wait_all();
+        Ti.stop();
+
+        cout << "\n" << threads << " threads  futures: " << one_each
+             << "  load_range: " << blocks / Ti.duration() / 1.0e6;
+    }
+
+    // many threads outside the pool submitting at once
+    cout << "\n\ninjection contention in millions of tasks per second\n";
+
+    {
+        size_t items = 400000;
+
+        // a task that is only passed around, never run
+        std::unique_ptr<Pool_Task> token(pool_task([] {}));
+
+        for(size_t producers = 1; producers <= 64; producers *= 2) {
+
+            Injection_Queue ring(1024);
+            Locked_Queue locked;
+
+            double lock_free = contention(ring, producers, items, token.get());
+            double lock_based = contention(locked, producers, items, token.get());
+
+            // through the pool with a small queue, counting refusals
+            Thread_Pool TP(4, 'f', 1, 1024);
+
+            std::atomic<size_t> count(0);
+            std::atomic<size_t> refused(0);
+
+            std::vector<std::thread> threads;
+
+            size_t each = items / producers;
+
+            Ti.start();
+
+            for(size_t p = 0; p < producers; ++p) {
+
+                threads.push_back(std::thread([&TP, &count, &refused, each] {
+
+                    for(size_t i = 0; i < each; ++i) {
+
+                        while(!TP.try_load_back([&count] { count.fetch_add(1); }).valid()) {
+
+                            refused.fetch_add(1);
+
+                            std::this_thread::yield();
+                        }
+                    }
+                }));
+            }
+
+            for(size_t p = 0; p < producers; ++p) { threads[p].join(); }
+
+            while(count.load() != each * producers) { std::this_thread::yield(); }
+
+            Ti.stop();
+
+            cout << "\n" << producers << " producers  lock-free queue: " << lock_free
+                 << "  locked deque: " << lock_based
+                 << "  pool: " << each * producers / Ti.duration() / 1.0e6
+                 << "  refused when full: " << refused.load();
+        }
+    }
+
+    cout << "\n";
+
+    // submit-to-start latency with the workers parked between tasks
+    {
+        typedef std::chrono::steady_clock clock;
+
+        Thread_Pool TP(4, 'f', 1);
+
+        std::vector<double> latency;
+
+        for(size_t i = 0; i < 200; ++i) {
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+            clock::time_point submitted = clock::now();
+
+            std::future<clock::time_point> started = TP.load_back([] { return clock::now(); });
+
+            latency.push_back(std::chrono::duration<double, std::micro>(started.get() - submitted).count());
+        }
+
+        std::sort(latency.begin(), latency.end());
+
+        cout << "\nidle pool latency, median: " << latency[latency.size() / 2]
+             << " us  99th percentile: " << latency[latency.size() * 99 / 100] << " us";
+
+        // processor time used by the whole process while the pool idles
+        std::clock_t before = std::clock();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        std::clock_t after = std::clock();
+
+        cout << "\nidle CPU time over 500 ms with 4 workers: "
+             << 1000.0 * (after - before) / CLOCKS_PER_SEC << " ms";
+    }
+
+    cout << "\n" << endl;
+
+    return 0;
+}
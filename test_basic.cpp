@@ -1,8 +1,11 @@
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 #include "Matrix.hpp"
 #include "Utilities.hpp"
 #include "Algebra.hpp"
+#include "Timer.hpp"
 
 template<typename T>
 void print(const Matrix<T>& M) {
@@ -21,6 +24,41 @@ void print(const Matrix<T>& M) {
 	std::cout << std::endl;
 }
 
+// largest element-wise difference between two matrices of the same shape
+template<typename X, typename Y>
+double max_error(const X& A, const Y& B) {
+
+	double error = 0.0;
+
+	for(size_t i = 0; i < A.rows(); ++i) {
+
+		for(size_t j = 0; j < A.columns(); ++j) {
+
+			error = std::max(error, std::fabs(A(i, j) - B(i, j)));
+		}
+	}
+
+	return error;
+}
+
+// products, inverses and determinants of fixed matrices against heap
+// matrices, returns the number of mismatches
+template<size_t N>
+size_t check_fixed(const Matrix<double>& S, Algebra& Al) {
+
+	Fixed_Matrix<double, N, N> FS(S);
+
+	size_t wrong = 0;
+
+	double det = Al.determinant(S);
+
+	wrong += max_error(S * S, FS * FS) > 1e-12;
+	wrong += max_error(Al.inverse(S), Al.inverse(FS)) > 1e-10;
+	wrong += std::fabs(det - Al.determinant(FS)) > 1e-10 * std::fabs(det);
+
+	return wrong;
+}
+
 int main() {
 
 	std::cout << "\n";
@@ -54,5 +92,101 @@ int main() {
 	Ut.round_values(R);
 	print<double>(R);
 
-	return 0;
+	size_t wrong = 0;
+
+	// expressions against element-wise loops
+	{
+		Matrix<double> B(dim, dim);
+		Matrix<double> D(dim, dim);
+		Ut.randomize(B, -1.0, 1.0);
+		Ut.randomize(D, -1.0, 1.0);
+
+		Matrix<double> C = M + B - D;
+		Matrix<double> E = 2.5 * M;
+		Matrix<double> G = M.slice(0, 2, 0, 2) + B.slice(2, 4, 2, 4);
+
+		for(size_t i = 0; i < dim; ++i) {
+
+			for(size_t j = 0; j < dim; ++j) {
+
+				wrong += C(i, j) != M(i, j) + B(i, j) - D(i, j);
+				wrong += E(i, j) != 2.5 * M(i, j);
+
+				if(i < 2 && j < 2) { wrong += G(i, j) != M(i, j) + B(i + 2, j + 2); }
+			}
+		}
+
+		// a matrix on both sides, in place and resized
+		Matrix<double> H = M;
+		H = H + B - H;
+		wrong += max_error(H, B) > 1e-15;
+
+		H = M;
+		H = 0.5 * H.slice(1, 3, 0, dim);
+		wrong += H.rows() != 2 || max_error(H, 0.5 * M.slice(1, 3, 0, dim)) != 0.0;
+
+		// an empty view makes no matrix
+		bool caught = false;
+		try { Matrix<double> Z = M.slice(1, 1, 0, dim) + M.slice(2, 2, 0, dim); }
+		catch(std::out_of_range&) { caught = true; }
+		wrong += !caught;
+	}
+
+	// fixed matrices against heap matrices, the 2x2 and 3x3 closed forms
+	// and the 4x4 elimination, once with a zero in the first pivot. a
+	// heavy anti-diagonal keeps the inverses well conditioned and makes
+	// the eliminations swap rows
+	for(size_t n = 2; n <= 4; ++n) {
+
+		Matrix<double> F(n, n);
+		Ut.randomize(F, -1.0, 1.0);
+
+		for(size_t i = 0; i < n; ++i) { F(i, n - 1 - i) += double(n); }
+
+		if(n == 2) { wrong += check_fixed<2>(F, Al); }
+		if(n == 3) { wrong += check_fixed<3>(F, Al); }
+		if(n == 4) { wrong += check_fixed<4>(F, Al); F(0, 0) = 0.0; wrong += check_fixed<4>(F, Al); }
+	}
+
+	std::cout << "fixed matrix and expression mismatches: " << wrong << "\n";
+
+	// 4x4 products on heap matrices against fixed size matrices, the
+	// product is scaled back every 64 steps so it neither vanishes into
+	// denormals nor overflows
+	Timer<double> Ti;
+	size_t reps = 1000000;
+
+	Matrix<double> S(4, 4);
+	Ut.randomize(S, -0.5, 0.5);
+
+	Matrix<double> T = S;
+
+	Ti.start();
+	for(size_t i = 0; i < reps; ++i) {
+
+		T = S * T;
+
+		if(i % 64 == 63) { T = (1.0 / max_error(T, Matrix<double>(4, 4))) * T; }
+	}
+	Ti.stop();
+	std::cout << "4x4 Matrix products: " << Ti.duration() << "\n";
+
+	Fixed_Matrix<double, 4, 4> FS(S);
+	Fixed_Matrix<double, 4, 4> FT = FS;
+
+	Ti.start();
+	for(size_t i = 0; i < reps; ++i) {
+
+		FT = FS * FT;
+
+		if(i % 64 == 63) { FT = (1.0 / max_error(FT, Fixed_Matrix<double, 4, 4>())) * FT; }
+	}
+	Ti.stop();
+	std::cout << "4x4 Fixed_Matrix products: " << Ti.duration() << "\n";
+
+	// the scaled products stay comparable
+	std::cout << "difference: " << max_error(T, FT) << "  largest entry: "
+			  << max_error(T, Matrix<double>(4, 4)) << "\n" << std::endl;
+
+	return wrong != 0;
 }